@@ -0,0 +1,227 @@
+/* velox: animation.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "animation.h"
+#include "config.h"
+#include "stats.h"
+#include "util.h"
+#include "velox.h"
+#include "window.h"
+
+#include <swc.h>
+#include <sys/param.h>
+#include <wayland-server.h>
+
+static unsigned duration_ms = 0;
+static unsigned rate_hz = 60;
+static unsigned configure_rate_hz = 0;
+
+static struct wl_list animations = { &animations, &animations };
+static struct wl_event_source *timer;
+
+static bool
+duration_ms_set(struct config_node *node, const char *value)
+{
+	struct window *window, *tmp;
+
+	if (!config_set_unsigned(&duration_ms, value, 0))
+		return false;
+
+	/* Finish the running animations at once if animations were turned off. */
+	if (duration_ms == 0) {
+		wl_list_for_each_safe (window, tmp, &animations, animation.link)
+			animation_finish(window);
+	}
+
+	return true;
+}
+
+static bool
+rate_hz_set(struct config_node *node, const char *value)
+{
+	unsigned rate;
+
+	if (!config_set_unsigned(&rate, value, 0) || rate == 0 || rate > 1000)
+		return false;
+
+	rate_hz = rate;
+
+	return true;
+}
+
+static bool
+configure_rate_hz_set(struct config_node *node, const char *value)
+{
+	return config_set_unsigned(&configure_rate_hz, value, 0);
+}
+
+static void
+duration_ms_get(struct config_node *node, char *value, size_t size)
+{
+	config_get_unsigned(value, size, duration_ms, 10);
+}
+
+static void
+rate_hz_get(struct config_node *node, char *value, size_t size)
+{
+	config_get_unsigned(value, size, rate_hz, 10);
+}
+
+static void
+configure_rate_hz_get(struct config_node *node, char *value, size_t size)
+{
+	config_get_unsigned(value, size, configure_rate_hz, 10);
+}
+
+static CONFIG_GROUP(animation);
+static CONFIG_PROPERTY(duration_ms, &duration_ms_set, &duration_ms_get);
+static CONFIG_PROPERTY(rate_hz, &rate_hz_set, &rate_hz_get);
+static CONFIG_PROPERTY(configure_rate_hz, &configure_rate_hz_set, &configure_rate_hz_get);
+
+bool
+animation_add_config_nodes()
+{
+	return config_add_node(&animation_group, &duration_ms_property)
+	    && config_add_node(&animation_group, &rate_hz_property)
+	    && config_add_node(&animation_group, &configure_rate_hz_property)
+	    && config_add_node(config_root, &animation_group);
+}
+
+static int32_t
+interpolate(int32_t from, int32_t to, double progress)
+{
+	return from + (int32_t)((to - from) * progress);
+}
+
+static void
+step(struct window *window, uint64_t now)
+{
+	struct animation *animation = &window->animation;
+	struct swc_rectangle geometry;
+	double progress;
+
+	if (now - animation->start >= duration_ms) {
+		animation_finish(window);
+		return;
+	}
+
+	/* Ease out, so the window slows down as it reaches its place. */
+	progress = 1 - (double)(now - animation->start) / duration_ms;
+	progress = 1 - progress * progress * progress;
+
+	geometry.x = interpolate(animation->from.x, animation->to.x, progress);
+	geometry.y = interpolate(animation->from.y, animation->to.y, progress);
+	geometry.width = interpolate(animation->from.width, animation->to.width, progress);
+	geometry.height = interpolate(animation->from.height, animation->to.height, progress);
+
+	/* Resizing makes the client draw again, so within the animation the window
+	 * is normally only moved. */
+	if (configure_rate_hz && now - animation->last_configure >= 1000 / MIN(configure_rate_hz, 1000)) {
+		window_configure(window, &geometry);
+		animation->last_configure = now;
+	} else if (geometry.x != window->geometry.x || geometry.y != window->geometry.y) {
+		swc_window_set_position(window->swc, geometry.x, geometry.y);
+		window->geometry.x = geometry.x;
+		window->geometry.y = geometry.y;
+		stats_count(STATS_ANIMATION_MOVES);
+	}
+}
+
+static void
+schedule_tick(uint64_t now)
+{
+	unsigned interval = 1000 / rate_hz;
+
+	/* Ticks fall on a fixed grid of intervals, so that they don't drift
+	 * however long each one takes. The delay is always positive, since 0 would
+	 * disarm the timer. */
+	wl_event_source_timer_update(timer, interval - now % interval);
+}
+
+static int
+tick(void *data)
+{
+	struct window *window, *tmp;
+	uint64_t now = now_ms();
+
+	wl_list_for_each_safe (window, tmp, &animations, animation.link)
+		step(window, now);
+
+	if (!wl_list_empty(&animations))
+		schedule_tick(now);
+
+	return 0;
+}
+
+bool
+animation_enabled()
+{
+	return duration_ms != 0;
+}
+
+void
+animation_start(struct window *window, const struct swc_rectangle *geometry)
+{
+	struct animation *animation = &window->animation;
+	uint64_t now = now_ms();
+
+	if (!timer && !(timer = wl_event_loop_add_timer(velox.event_loop, &tick, NULL))) {
+		window_configure(window, geometry);
+		return;
+	}
+
+	/* A running animation carries on from wherever the window is now. */
+	animation->from = window->geometry;
+	animation->to = *geometry;
+	animation->start = now;
+	animation->last_configure = now;
+
+	if (!animation_running(animation)) {
+		if (wl_list_empty(&animations))
+			schedule_tick(now);
+		wl_list_insert(animations.prev, &animation->link);
+	}
+}
+
+void
+animation_finish(struct window *window)
+{
+	struct animation *animation = &window->animation;
+	struct swc_rectangle *geometry = &window->geometry;
+
+	if (!animation_running(animation))
+		return;
+
+	animation_cancel(window);
+
+	if (geometry->x != animation->to.x || geometry->y != animation->to.y
+	    || geometry->width != animation->to.width || geometry->height != animation->to.height)
+		window_configure(window, &animation->to);
+}
+
+void
+animation_cancel(struct window *window)
+{
+	wl_list_remove(&window->animation.link);
+	wl_list_init(&window->animation.link);
+}
@@ -0,0 +1,75 @@
+/* velox: animation.h
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VELOX_ANIMATION_H
+#define VELOX_ANIMATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <swc.h>
+#include <wayland-util.h>
+
+struct window;
+
+struct animation {
+	/* Link in the list of running animations, or initialized if the window
+	 * isn't animating. */
+	struct wl_list link;
+	struct swc_rectangle from, to;
+	uint64_t start, last_configure;
+};
+
+bool animation_add_config_nodes();
+
+/**
+ * Whether geometry changes of shown windows are animated, which is the case
+ * if animation.duration_ms is not 0.
+ */
+bool animation_enabled();
+
+/**
+ * Move a window towards a new geometry over animation.duration_ms, starting
+ * from the geometry it was last sent.
+ *
+ * Until the animation ends, the window is only moved, and only resized at
+ * animation.configure_rate_hz if that is not 0.
+ */
+void animation_start(struct window *window, const struct swc_rectangle *geometry);
+
+/**
+ * Stop a window's animation, if it has one, and give it its final geometry.
+ */
+void animation_finish(struct window *window);
+
+/**
+ * Stop a window's animation, if it has one, leaving it where it is.
+ */
+void animation_cancel(struct window *window);
+
+static inline bool
+animation_running(const struct animation *animation)
+{
+	return !wl_list_empty(&animation->link);
+}
+
+#endif
@@ -0,0 +1,272 @@
+/* velox: bench/bench.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "bench.h"
+#include "layout.h"
+#include "screen.h"
+#include "tag.h"
+#include "util.h"
+#include "velox.h"
+#include "window.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <wayland-server.h>
+
+#define NUM_TAG_OPS 10000
+
+extern const struct swc_manager manager;
+
+static const struct swc_rectangle area = { 0, 0, 1920, 1080 };
+static unsigned num_tags = DEFAULT_NUM_TAGS;
+static uint32_t seed = 1;
+
+/* xorshift32, so that every run performs the same operations. */
+static uint32_t
+random_next()
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+static void
+report(const char *name, unsigned long ops, uint64_t ns, const struct stub_stats *start)
+{
+	printf("%-28s %12.1f ns/op %10.2f configures/op %8.2f shows/op %8.2f hides/op\n",
+	       name, (double)ns / ops,
+	       (double)(stub_stats.configures - start->configures) / ops,
+	       (double)(stub_stats.shows - start->shows) / ops,
+	       (double)(stub_stats.hides - start->hides) / ops);
+}
+
+static void
+flush()
+{
+	wl_event_loop_dispatch(velox.event_loop, 0);
+}
+
+static struct stub_screen *
+add_screens(unsigned num_screens)
+{
+	struct stub_screen *screens;
+	unsigned index;
+
+	if (!(screens = calloc(num_screens, sizeof *screens)))
+		return NULL;
+
+	for (index = 0; index < num_screens; ++index) {
+		screens[index].base.geometry = (struct swc_rectangle){
+			area.x + index * area.width, area.y, area.width, area.height,
+		};
+		screens[index].base.usable_geometry = screens[index].base.geometry;
+		manager.new_screen(&screens[index].base);
+	}
+
+	return screens;
+}
+
+/* Create windows on the active screen's tag, or on random tags if spread is
+ * set. */
+static struct stub_window *
+add_windows(unsigned num_windows, bool spread)
+{
+	struct stub_window *windows;
+	unsigned index;
+
+	if (!(windows = calloc(num_windows, sizeof *windows)))
+		return NULL;
+
+	for (index = 0; index < num_windows; ++index) {
+		manager.new_window(&windows[index].base);
+		if (spread && windows[index].data)
+			window_set_tag(windows[index].data, velox.tags[random_next() % velox.num_tags]);
+	}
+	flush();
+
+	return windows;
+}
+
+/* The layout kernels on their own, without any windows being configured. */
+static void
+bench_layout(const char *name, struct layout *layout, unsigned num_windows)
+{
+	struct window *windows[num_windows];
+	struct swc_rectangle rects[num_windows];
+	struct stub_stats stats = stub_stats;
+	unsigned long iteration, num_iterations = 2000000 / num_windows + 100;
+	uint64_t start;
+	char label[64];
+
+	memset(windows, 0, sizeof windows);
+	start = now_ns();
+	for (iteration = 0; iteration < num_iterations; ++iteration)
+		layout_arrange_all(layout, &area, 2, windows, num_windows, rects);
+	snprintf(label, sizeof label, "layout/%s/%u", name, num_windows);
+	report(label, num_iterations, now_ns() - start, &stats);
+}
+
+/* Arranging a screen, once with a border width change every time so that all
+ * windows are configured, and once with nothing to change. */
+static bool
+bench_arrange(unsigned num_screens, unsigned num_windows)
+{
+	struct screen *screen;
+	struct stub_stats stats;
+	unsigned long iteration, num_iterations = 200000 / num_windows + 10;
+	uint64_t start;
+	char label[64];
+
+	if (!add_screens(num_screens) || !add_windows(num_windows, false))
+		return false;
+	screen = velox.active_screen;
+
+	stats = stub_stats;
+	start = now_ns();
+	for (iteration = 0; iteration < num_iterations; ++iteration) {
+		screen->border_width = 1 + iteration % 2;
+		screen_arrange(screen);
+	}
+	snprintf(label, sizeof label, "arrange/changed/%u", num_windows);
+	report(label, num_iterations, now_ns() - start, &stats);
+
+	stats = stub_stats;
+	start = now_ns();
+	for (iteration = 0; iteration < num_iterations; ++iteration)
+		screen_arrange(screen);
+	snprintf(label, sizeof label, "arrange/unchanged/%u", num_windows);
+	report(label, num_iterations, now_ns() - start, &stats);
+
+	return true;
+}
+
+/* Random tag activations and toggles on random screens, each followed by the
+ * update that velox would run once idle. */
+static bool
+bench_tags(unsigned num_screens, unsigned num_windows)
+{
+	struct stub_screen *screens;
+	struct screen *screen;
+	struct tag *tag;
+	struct stub_stats stats;
+	struct tag_mask mask;
+	unsigned op;
+	uint32_t value;
+	uint64_t start;
+	char label[64];
+
+	if (!(screens = add_screens(num_screens)) || !add_windows(num_windows, true))
+		return false;
+
+	stats = stub_stats;
+	start = now_ns();
+	for (op = 0; op < NUM_TAG_OPS; ++op) {
+		value = random_next();
+		screen = screens[value % num_screens].data;
+		value /= num_screens;
+		tag = velox.tags[value / 2 % velox.num_tags];
+
+		/* Either activate the tag, or toggle it unless it is the only
+		 * one on the screen. */
+		memset(&mask, 0, sizeof mask);
+		tag_mask_add(&mask, tag);
+		if (value % 2 && !tag_mask_equal(&screen->mask, &mask)) {
+			mask = screen->mask;
+			tag_mask_toggle(&mask, tag);
+		}
+		screen_set_tags(screen, &mask);
+		flush();
+	}
+	snprintf(label, sizeof label, "tags/%u-tags/%u-screens/%u", velox.num_tags, num_screens, num_windows);
+	report(label, NUM_TAG_OPS, now_ns() - start, &stats);
+
+	return true;
+}
+
+/* Run a benchmark in a fresh process, since velox has no way to tear down
+ * screens. */
+static bool
+run(bool (*bench)(unsigned, unsigned), unsigned num_screens, unsigned num_windows)
+{
+	pid_t pid;
+	int status;
+
+	fflush(stdout);
+
+	if ((pid = fork()) == 0) {
+		if (!bench_setup(num_tags) || !bench(num_screens, num_windows)) {
+			fprintf(stderr, "Benchmark failed with %u screens and %u windows\n", num_screens, num_windows);
+			_exit(EXIT_FAILURE);
+		}
+		fflush(stdout);
+		_exit(EXIT_SUCCESS);
+	}
+
+	return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const unsigned window_counts[] = { 1, 10, 100, 1000 };
+	static const unsigned screen_counts[] = { 1, 2, 4, 8 };
+	static const unsigned tag_counts[] = { DEFAULT_NUM_TAGS, MAX_TAGS };
+	static const struct {
+		const char *name;
+		struct layout *(*new)();
+	} layouts[] = {
+		{ "tall", &tall_layout_new },
+		{ "grid", &grid_layout_new },
+		{ "stack", &stack_layout_new },
+	};
+	struct layout *layout;
+	unsigned i, j, k;
+	bool success = true;
+
+	for (i = 0; i < ARRAY_LENGTH(layouts); ++i) {
+		if (!(layout = layouts[i].new()))
+			return EXIT_FAILURE;
+		for (j = 0; j < ARRAY_LENGTH(window_counts); ++j)
+			bench_layout(layouts[i].name, layout, window_counts[j]);
+		free(layout);
+	}
+
+	for (j = 0; j < ARRAY_LENGTH(window_counts); ++j)
+		success = run(&bench_arrange, 1, window_counts[j]) && success;
+
+	for (k = 0; k < ARRAY_LENGTH(tag_counts); ++k) {
+		num_tags = tag_counts[k];
+		for (i = 0; i < ARRAY_LENGTH(screen_counts); ++i) {
+			for (j = 0; j < ARRAY_LENGTH(window_counts); ++j)
+				success = run(&bench_tags, screen_counts[i], window_counts[j]) && success;
+		}
+	}
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
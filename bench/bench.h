@@ -0,0 +1,55 @@
+/* velox: bench/bench.h
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VELOX_BENCH_BENCH_H
+#define VELOX_BENCH_BENCH_H
+
+#include <stdbool.h>
+#include <swc.h>
+
+/* A window created by the benchmark, standing in for one made by swc. */
+struct stub_window {
+	struct swc_window base;
+	const struct swc_window_handler *handler;
+	void *data;
+};
+
+/* A screen created by the benchmark. */
+struct stub_screen {
+	struct swc_screen base;
+	const struct swc_screen_handler *handler;
+	void *data;
+};
+
+/* Number of calls that would have reached the compositor. */
+extern struct stub_stats {
+	unsigned long configures, shows, hides;
+} stub_stats;
+
+/**
+ * Create the display and the given number of tags the way velox's main
+ * function does, without starting a compositor.
+ */
+bool bench_setup(unsigned num_tags);
+
+#endif
@@ -0,0 +1,27 @@
+# velox: bench/local.mk
+
+dir := bench
+
+$(dir)_TARGETS := $(dir)/bench
+$(dir)_PACKAGES := swc wayland-server xkbcommon
+# swc is replaced by a stub, so only its headers are needed.
+$(dir)_PACKAGE_LIBS := $(call pkgconfig,wayland-server xkbcommon,libs,LIBS)
+
+BENCH_OBJECTS :=                \
+    $(dir)/bench.o              \
+    $(dir)/swc.o                \
+    $(dir)/velox.o              \
+    $(filter-out velox.o,$(VELOX_OBJECTS))
+
+CLEAN_FILES += $($(dir)_TARGETS) $(filter $(dir)/%,$(BENCH_OBJECTS))
+
+$(dir)/velox.o: velox.c protocol/velox-server-protocol.h
+
+$(dir)/bench: $(BENCH_OBJECTS)
+	$(link) $(bench_PACKAGE_LIBS) -lpthread
+
+.PHONY: bench
+bench: $(dir)/bench
+	./$<
+
+include common.mk
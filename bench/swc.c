@@ -0,0 +1,139 @@
+/* velox: bench/swc.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Just enough of swc for velox to manage windows without a compositor. */
+
+#include "bench.h"
+
+#include <swc.h>
+
+struct stub_stats stub_stats;
+
+bool
+swc_initialize(struct wl_display *display, struct wl_event_loop *event_loop, const struct swc_manager *manager)
+{
+	return true;
+}
+
+void
+swc_finalize()
+{
+}
+
+int
+swc_add_binding(enum swc_binding_type type, uint32_t modifiers, uint32_t value,
+                swc_binding_handler handler, void *data)
+{
+	return 0;
+}
+
+void
+swc_screen_set_handler(struct swc_screen *base, const struct swc_screen_handler *handler, void *data)
+{
+	struct stub_screen *screen = wl_container_of(base, screen, base);
+
+	screen->handler = handler;
+	screen->data = data;
+}
+
+void
+swc_window_set_handler(struct swc_window *base, const struct swc_window_handler *handler, void *data)
+{
+	struct stub_window *window = wl_container_of(base, window, base);
+
+	window->handler = handler;
+	window->data = data;
+}
+
+void
+swc_window_show(struct swc_window *window)
+{
+	++stub_stats.shows;
+}
+
+void
+swc_window_hide(struct swc_window *window)
+{
+	++stub_stats.hides;
+}
+
+void
+swc_window_set_geometry(struct swc_window *window, const struct swc_rectangle *geometry)
+{
+	++stub_stats.configures;
+}
+
+void
+swc_window_close(struct swc_window *window)
+{
+}
+
+void
+swc_window_focus(struct swc_window *window)
+{
+}
+
+void
+swc_window_set_stacked(struct swc_window *window)
+{
+}
+
+void
+swc_window_set_tiled(struct swc_window *window)
+{
+}
+
+void
+swc_window_set_position(struct swc_window *window, int32_t x, int32_t y)
+{
+}
+
+void
+swc_window_set_size(struct swc_window *window, uint32_t width, uint32_t height)
+{
+}
+
+void
+swc_window_set_border(struct swc_window *window, uint32_t color, uint32_t width)
+{
+}
+
+void
+swc_window_begin_move(struct swc_window *window)
+{
+}
+
+void
+swc_window_end_move(struct swc_window *window)
+{
+}
+
+void
+swc_window_begin_resize(struct swc_window *window, uint32_t edges)
+{
+}
+
+void
+swc_window_end_resize(struct swc_window *window)
+{
+}
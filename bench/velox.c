@@ -0,0 +1,59 @@
+/* velox: bench/velox.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Build velox.c with its main function renamed, so that the benchmark can set
+ * up the same state and drive it directly. */
+
+#define main velox_main
+#include "../velox.c"
+
+#include "bench.h"
+
+bool
+bench_setup(unsigned num_tags)
+{
+	int index;
+	char tag_name[8];
+
+	if (!(velox.display = wl_display_create()))
+		return false;
+
+	velox.event_loop = wl_display_get_event_loop(velox.display);
+	wl_list_init(&velox.screens);
+	wl_list_init(&velox.visibility_changes);
+	wl_list_init(&velox.unused_tags);
+	if (!add_config_nodes())
+		return false;
+
+	velox.num_tags = num_tags;
+	for (index = 0; index < velox.num_tags; ++index) {
+		snprintf(tag_name, sizeof tag_name, "%d", index + 1);
+		if (!(velox.tags[index] = tag_new(index, tag_name)))
+			return false;
+	}
+
+	for (index = velox.num_tags - 1; index >= 0; --index)
+		tag_add(velox.tags[index], NULL);
+
+	return swc_initialize(velox.display, velox.event_loop, &manager);
+}
@@ -0,0 +1,162 @@
+/* velox: clients/command.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Run velox commands, one per argument, or one per line of standard input if
+ * there are no arguments. For example:
+ *
+ *     command "run tag.3.activate" "set window.border_width 4" */
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-client.h>
+
+#include "protocol/swc-client-protocol.h"
+#include "protocol/velox-client-protocol.h"
+
+static void registry_global(void *data, struct wl_registry *registry,
+                            uint32_t name, const char *interface, uint32_t version);
+static void registry_global_remove(void *data, struct wl_registry *registry, uint32_t name);
+
+static void command_failed(void *data, struct velox_command *command, uint32_t index);
+static void command_done(void *data, struct velox_command *command, uint32_t num_commands);
+
+static struct wl_display *display;
+static struct wl_registry *registry;
+static struct velox *velox;
+static bool failed, done;
+
+static const struct wl_registry_listener registry_listener = {
+	.global = &registry_global,
+	.global_remove = &registry_global_remove
+};
+
+static const struct velox_command_listener command_listener = {
+	.failed = &command_failed,
+	.done = &command_done,
+};
+
+static void __attribute__((noreturn)) die(const char *const format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	fputs("FATAL: ", stderr);
+	vfprintf(stderr, format, args);
+	fputc('\n', stderr);
+	va_end(args);
+	exit(EXIT_FAILURE);
+}
+
+static void
+registry_global(void *data, struct wl_registry *registry,
+                uint32_t name, const char *interface, uint32_t version)
+{
+	if (strcmp(interface, "velox") == 0 && version >= VELOX_RUN_COMMANDS_SINCE_VERSION)
+		velox = wl_registry_bind(registry, name, &velox_interface, VELOX_RUN_COMMANDS_SINCE_VERSION);
+}
+
+static void
+registry_global_remove(void *data, struct wl_registry *registry, uint32_t name)
+{
+}
+
+static void
+command_failed(void *data, struct velox_command *command, uint32_t index)
+{
+	fprintf(stderr, "Command %" PRIu32 " failed\n", index + 1);
+	failed = true;
+}
+
+static void
+command_done(void *data, struct velox_command *command, uint32_t num_commands)
+{
+	velox_command_destroy(command);
+	done = true;
+}
+
+static void
+append(char **commands, size_t *length, const char *command)
+{
+	size_t size = strlen(command);
+
+	if (!(*commands = realloc(*commands, *length + size + 2)))
+		die("Failed to allocate commands");
+
+	memcpy(*commands + *length, command, size);
+	*length += size;
+	(*commands)[(*length)++] = '\n';
+	(*commands)[*length] = '\0';
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct velox_command *command;
+	char *commands = NULL, line[1024];
+	size_t length = 0;
+	int index;
+
+	if (argc > 1) {
+		for (index = 1; index < argc; ++index)
+			append(&commands, &length, argv[index]);
+	} else {
+		while (fgets(line, sizeof line, stdin)) {
+			line[strcspn(line, "\n")] = '\0';
+			append(&commands, &length, line);
+		}
+	}
+
+	if (!commands)
+		return EXIT_SUCCESS;
+
+	if (!(display = wl_display_connect(NULL)))
+		die("Failed to connect to display");
+
+	if (!(registry = wl_display_get_registry(display)))
+		die("Failed to get registry");
+
+	wl_registry_add_listener(registry, &registry_listener, NULL);
+	wl_display_roundtrip(display);
+
+	if (!velox)
+		die("Compositor does not support velox commands");
+
+	/* All of the commands are sent in a single request. */
+	if (!(command = velox_run_commands(velox, commands)))
+		die("Failed to send commands");
+
+	velox_command_add_listener(command, &command_listener, NULL);
+
+	while (!done) {
+		if (wl_display_dispatch(display) == -1)
+			die("Failed to dispatch events");
+	}
+
+	free(commands);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
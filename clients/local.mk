@@ -2,7 +2,7 @@
 
 dir := clients
 
-$(dir)_TARGETS := $(dir)/status_bar
+$(dir)_TARGETS := $(dir)/status_bar $(dir)/stats $(dir)/snapshot $(dir)/command
 $(dir)_PACKAGES := pixman-1 wld wayland-client
 
 $(dir)/status_bar.o: $(call client_protocol,velox swc)
@@ -10,7 +10,22 @@ $(dir)/status_bar.o: $(call client_protocol,velox swc)
 $(dir)/status_bar: $(dir)/status_bar.o $(call protocol,velox swc)
 	$(link) $(clients_PACKAGE_LIBS) -lrt
 
-install-clients: $($(dir)_TARGETS) | $(DESTDIR)$(LIBEXECDIR)/velox
+$(dir)/stats.o: $(call client_protocol,velox swc)
+
+$(dir)/stats: $(dir)/stats.o $(call protocol,velox swc)
+	$(link) $(clients_PACKAGE_LIBS)
+
+$(dir)/snapshot.o: $(call client_protocol,velox swc)
+
+$(dir)/snapshot: $(dir)/snapshot.o $(call protocol,velox swc)
+	$(link) $(clients_PACKAGE_LIBS)
+
+$(dir)/command.o: $(call client_protocol,velox swc)
+
+$(dir)/command: $(dir)/command.o $(call protocol,velox swc)
+	$(link) $(clients_PACKAGE_LIBS)
+
+install-clients: $(dir)/status_bar | $(DESTDIR)$(LIBEXECDIR)/velox
 	install -m 755 $^ $(DESTDIR)$(LIBEXECDIR)/velox
 
 include common.mk
@@ -0,0 +1,197 @@
+/* velox: clients/snapshot.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Print the compositor state from a velox_snapshot, and again whenever it
+ * changes if -f is given. */
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <wayland-client.h>
+
+#include "protocol/velox-client-protocol.h"
+#include "protocol/velox-snapshot.h"
+
+static void registry_global(void *data, struct wl_registry *registry,
+                            uint32_t name, const char *interface, uint32_t version);
+static void registry_global_remove(void *data, struct wl_registry *registry, uint32_t name);
+
+static void snapshot_memory(void *data, struct velox_snapshot *snapshot, int32_t fd, uint32_t size);
+static void snapshot_changed(void *data, struct velox_snapshot *snapshot, uint32_t sequence);
+
+static struct wl_display *display;
+static struct wl_registry *registry;
+static struct velox *velox;
+static const struct velox_snapshot *shared;
+static bool follow;
+
+static const struct wl_registry_listener registry_listener = {
+	.global = &registry_global,
+	.global_remove = &registry_global_remove
+};
+
+static const struct velox_snapshot_listener snapshot_listener = {
+	.memory = &snapshot_memory,
+	.changed = &snapshot_changed,
+};
+
+static void __attribute__((noreturn)) die(const char *const format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	fputs("FATAL: ", stderr);
+	vfprintf(stderr, format, args);
+	fputc('\n', stderr);
+	va_end(args);
+	exit(EXIT_FAILURE);
+}
+
+static void
+print(const struct velox_snapshot *snapshot)
+{
+	const struct velox_snapshot_screen *screen;
+	const struct velox_snapshot_tag *tag;
+	unsigned index;
+
+	printf("sequence %" PRIu32 "\n", snapshot->sequence);
+
+	for (index = 0; index < snapshot->num_screens; ++index) {
+		screen = &snapshot->screens[index];
+		printf("screen %u%s: %" PRIi32 ",%" PRIi32 " %" PRIu32 "x%" PRIu32 ", %" PRIu32 " windows, focus \"%s\"",
+		       index, (int32_t)index == snapshot->active_screen ? " (active)" : "",
+		       screen->x, screen->y, screen->width, screen->height, screen->num_windows, screen->title);
+		if (screen->focus_tag >= 0)
+			printf(" on %s", snapshot->tags[screen->focus_tag].name);
+		putchar('\n');
+	}
+
+	for (index = 0; index < snapshot->num_tags; ++index) {
+		tag = &snapshot->tags[index];
+		printf("tag %s: %" PRIu32 " windows", tag->name, tag->num_windows);
+		if (tag->screen >= 0)
+			printf(", on screen %" PRIi32, tag->screen);
+		putchar('\n');
+	}
+
+	fflush(stdout);
+}
+
+static void
+registry_global(void *data, struct wl_registry *registry,
+                uint32_t name, const char *interface, uint32_t version)
+{
+	if (strcmp(interface, "velox") == 0 && version >= VELOX_GET_SNAPSHOT_SINCE_VERSION)
+		velox = wl_registry_bind(registry, name, &velox_interface, VELOX_GET_SNAPSHOT_SINCE_VERSION);
+}
+
+static void
+registry_global_remove(void *data, struct wl_registry *registry, uint32_t name)
+{
+}
+
+static void
+snapshot_memory(void *data, struct velox_snapshot *snapshot, int32_t fd, uint32_t size)
+{
+	if (size < sizeof *shared)
+		die("Snapshot is too small");
+
+	shared = mmap(NULL, sizeof *shared, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (shared == MAP_FAILED)
+		die("Failed to map snapshot");
+}
+
+static void
+snapshot_changed(void *data, struct velox_snapshot *snapshot, uint32_t sequence)
+{
+	struct velox_snapshot copy;
+
+	if (!follow)
+		return;
+
+	if (!velox_snapshot_read(shared, &copy))
+		die("Unknown snapshot version %" PRIu32, copy.version);
+
+	print(&copy);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct velox_snapshot *snapshot;
+	struct velox_snapshot copy;
+	int option;
+
+	while ((option = getopt(argc, argv, "f")) != -1) {
+		switch (option) {
+		case 'f':
+			follow = true;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-f]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!(display = wl_display_connect(NULL)))
+		die("Failed to connect to display");
+
+	if (!(registry = wl_display_get_registry(display)))
+		die("Failed to get registry");
+
+	wl_registry_add_listener(registry, &registry_listener, NULL);
+	wl_display_roundtrip(display);
+
+	if (!velox)
+		die("Compositor does not support velox snapshots");
+
+	if (!(snapshot = velox_get_snapshot(velox)))
+		die("Failed to request snapshot");
+
+	velox_snapshot_add_listener(snapshot, &snapshot_listener, NULL);
+	wl_display_roundtrip(display);
+
+	if (!shared)
+		die("Compositor did not send the snapshot");
+
+	if (!velox_snapshot_read(shared, &copy))
+		die("Unknown snapshot version %" PRIu32, copy.version);
+
+	print(&copy);
+
+	while (follow) {
+		if (wl_display_dispatch(display) == -1)
+			die("Failed to dispatch events");
+	}
+
+	velox_snapshot_destroy(snapshot);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+/* velox: clients/stats.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Print the statistics gathered by a velox built with ENABLE_DEBUG. */
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-client.h>
+
+#include "protocol/swc-client-protocol.h"
+#include "protocol/velox-client-protocol.h"
+
+static void registry_global(void *data, struct wl_registry *registry,
+                            uint32_t name, const char *interface, uint32_t version);
+static void registry_global_remove(void *data, struct wl_registry *registry, uint32_t name);
+
+static void stats_timer(void *data, struct velox_stats *stats, const char *name, uint32_t count,
+                        uint32_t total_us, uint32_t max_ns, struct wl_array *histogram, struct wl_array *recent);
+static void stats_counter(void *data, struct velox_stats *stats, const char *name, uint32_t value);
+static void stats_done(void *data, struct velox_stats *stats);
+
+static struct wl_display *display;
+static struct wl_registry *registry;
+static struct velox *velox;
+static bool done;
+
+static const struct wl_registry_listener registry_listener = {
+	.global = &registry_global,
+	.global_remove = &registry_global_remove
+};
+
+static const struct velox_stats_listener stats_listener = {
+	.timer = &stats_timer,
+	.counter = &stats_counter,
+	.done = &stats_done,
+};
+
+static void __attribute__((noreturn)) die(const char *const format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	fputs("FATAL: ", stderr);
+	vfprintf(stderr, format, args);
+	fputc('\n', stderr);
+	va_end(args);
+	exit(EXIT_FAILURE);
+}
+
+static void
+registry_global(void *data, struct wl_registry *registry,
+                uint32_t name, const char *interface, uint32_t version)
+{
+	if (strcmp(interface, "velox") == 0 && version >= VELOX_GET_STATS_SINCE_VERSION)
+		velox = wl_registry_bind(registry, name, &velox_interface, VELOX_GET_STATS_SINCE_VERSION);
+}
+
+static void
+registry_global_remove(void *data, struct wl_registry *registry, uint32_t name)
+{
+}
+
+static void
+stats_timer(void *data, struct velox_stats *stats, const char *name, uint32_t count,
+            uint32_t total_us, uint32_t max_ns, struct wl_array *histogram, struct wl_array *recent)
+{
+	uint32_t *value;
+	unsigned bucket = 0;
+
+	printf("%s: %" PRIu32 " calls, %.3f ms total, %.3f ms max\n", name, count, total_us / 1e3, max_ns / 1e6);
+
+	wl_array_for_each (value, histogram) {
+		if (*value)
+			printf("  >= %10.3f us: %" PRIu32 "\n", (1ull << bucket) / 1e3, *value);
+		++bucket;
+	}
+
+	if (recent->size > 0) {
+		fputs("  recent (us):", stdout);
+		wl_array_for_each (value, recent)
+			printf(" %.1f", *value / 1e3);
+		putchar('\n');
+	}
+}
+
+static void
+stats_counter(void *data, struct velox_stats *stats, const char *name, uint32_t value)
+{
+	printf("%s: %" PRIu32 "\n", name, value);
+}
+
+static void
+stats_done(void *data, struct velox_stats *stats)
+{
+	velox_stats_destroy(stats);
+	done = true;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct velox_stats *stats;
+
+	if (!(display = wl_display_connect(NULL)))
+		die("Failed to connect to display");
+
+	if (!(registry = wl_display_get_registry(display)))
+		die("Failed to get registry");
+
+	wl_registry_add_listener(registry, &registry_listener, NULL);
+	wl_display_roundtrip(display);
+
+	if (!velox)
+		die("Compositor does not support velox statistics");
+
+	if (!(stats = velox_get_stats(velox)))
+		die("Failed to query statistics");
+
+	velox_stats_add_listener(stats, &stats_listener, NULL);
+
+	while (!done) {
+		if (wl_display_dispatch(display) == -1)
+			die("Failed to dispatch events");
+	}
+
+	return EXIT_SUCCESS;
+}
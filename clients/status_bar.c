@@ -42,19 +42,53 @@ enum align {
 	ALIGN_RIGHT,
 };
 
+#define ARRAY_LENGTH(array) (sizeof array / sizeof array[0])
+
+/* The number of buffers whose contents are remembered for partial redraws. */
+#define MAX_BUFFERS 3
+
+/* What an item looks like where it was drawn. */
+struct item_state {
+	uint32_t x, width, version;
+};
+
 struct item {
 	const struct item_interface *interface;
 	const struct item_data *data;
 	struct wl_list link;
+
+	/* The item's state in the next frame, the last frame, and in each of the
+	 * status bar's buffers. */
+	struct item_state state, shown, drawn[MAX_BUFFERS];
 };
 
 struct item_data {
 	uint32_t width;
+	/* Incremented whenever the item needs to be redrawn. */
+	uint32_t version;
 };
 
 struct text_item_data {
 	struct item_data base;
 	const char *text;
+	/* Whether the text changes too often to be worth caching. */
+	bool transient;
+};
+
+/* The number of text runs kept in the cache. */
+#define TEXT_CACHE_SIZE 32
+
+/* A measured piece of text, along with the colors it has been rendered in. */
+struct text_run {
+	struct wld_font *font;
+	char *text;
+	uint32_t width;
+	struct {
+		uint32_t fg, bg;
+		struct wld_buffer *buffer;
+	} renders[2];
+	unsigned num_renders;
+	struct wl_list link;
 };
 
 struct status_bar {
@@ -64,10 +98,22 @@ struct status_bar {
 	struct wld_surface *wld_surface;
 	uint32_t width, height;
 
+	/* The buffers that the items' drawn state refers to. */
+	struct wld_buffer *buffers[MAX_BUFFERS];
+	unsigned next_buffer;
+
+	/* Whether the bar needs to be drawn, and the frame callback we are waiting
+	 * on before drawing it again. */
+	bool dirty;
+	struct wl_callback *frame;
+
 	struct wl_list items[3];
 };
 
 struct item_interface {
+	/* Render anything the item needs into offscreen buffers, before the
+	 * frame it is drawn in begins. May be NULL. */
+	void (*prepare)(struct status_bar *status_bar, struct item *item);
 	void (*draw)(struct status_bar *status_bar, struct item *item, uint32_t x, uint32_t y);
 };
 
@@ -105,13 +151,19 @@ static void registry_global_remove(void *data, struct wl_registry *registry, uin
 
 static void panel_docked(void *data, struct swc_panel *panel, uint32_t length);
 
+static void frame_done(void *data, struct wl_callback *callback, uint32_t time);
+
 static void velox_screen_focus(void *data, struct velox_screen *velox_screen, const char *title, struct velox_tag *tag);
+static void velox_screen_done(void *data, struct velox_screen *velox_screen);
 static void velox_tag_name(void *data, struct velox_tag *tag, const char *name);
 static void velox_tag_state(void *data, struct velox_tag *tag, uint32_t num_windows);
 static void velox_tag_screen(void *data, struct velox_tag *tag, struct velox_screen *screen);
+static void velox_tag_done(void *data, struct velox_tag *tag);
 
 /* Item interfaces */
+static void text_prepare(struct status_bar *status_bar, struct item *item);
 static void text_draw(struct status_bar *status_bar, struct item *item, uint32_t x, uint32_t y);
+static void tag_prepare(struct status_bar *status_bar, struct item *item);
 static void tag_draw(struct status_bar *status_bar, struct item *item, uint32_t x, uint32_t y);
 static void divider_draw(struct status_bar *status_bar, struct item *item, uint32_t x, uint32_t y);
 
@@ -135,25 +187,33 @@ static const struct wl_registry_listener registry_listener = {
 	.global_remove = &registry_global_remove
 };
 
+static const struct wl_callback_listener frame_listener = {
+	.done = &frame_done,
+};
+
 static const struct swc_panel_listener panel_listener = {
 	.docked = &panel_docked
 };
 
 static const struct velox_screen_listener velox_screen_listener = {
 	.focus = &velox_screen_focus,
+	.done = &velox_screen_done,
 };
 
 static const struct velox_tag_listener velox_tag_listener = {
 	.name = &velox_tag_name,
 	.state = &velox_tag_state,
 	.screen = &velox_tag_screen,
+	.done = &velox_tag_done,
 };
 
 static const struct item_interface text_interface = {
+	.prepare = &text_prepare,
 	.draw = &text_draw
 };
 
 static const struct item_interface tag_interface = {
+	.prepare = &tag_prepare,
 	.draw = &tag_draw
 };
 
@@ -168,10 +228,14 @@ static const struct style normal = { .bg = 0xff1a1a1a, .fg = 0xff999999 };
 static const struct style selected = { .bg = 0xff338833, .fg = 0xffffffff };
 
 static timer_t timer;
-static bool running, need_draw;
+static bool running, need_draw, changes_pending;
 static char clock_text[32];
 static struct item_data divider_data = {.width = 14 };
-static struct text_item_data clock_data = {.text = clock_text };
+static struct text_item_data clock_data = {.text = clock_text, .transient = true };
+
+/* Text runs shared by all screens, most recently used first. */
+static struct wl_list text_cache = { &text_cache, &text_cache };
+static unsigned text_cache_size;
 
 static void __attribute__((noreturn)) die(const char *const format, ...)
 {
@@ -205,18 +269,156 @@ item_new(const struct item_interface *interface, const struct item_data *data)
 
 	item->interface = interface;
 	item->data = data;
+	memset(&item->shown, 0, sizeof item->shown);
+	memset(item->drawn, 0, sizeof item->drawn);
 
 	return item;
 }
 
+static void
+text_run_destroy(struct text_run *run)
+{
+	unsigned index;
+
+	for (index = 0; index < run->num_renders; ++index)
+		wld_buffer_unreference(run->renders[index].buffer);
+	wl_list_remove(&run->link);
+	free(run->text);
+	free(run);
+	--text_cache_size;
+}
+
+static struct text_run *
+text_run(struct wld_font *font, const char *text)
+{
+	struct text_run *run;
+	struct wld_extents extents;
+
+	wl_list_for_each (run, &text_cache, link) {
+		if (run->font == font && strcmp(run->text, text) == 0)
+			goto found;
+	}
+
+	if (!(run = malloc(sizeof *run)))
+		return NULL;
+	if (!(run->text = strdup(text))) {
+		free(run);
+		return NULL;
+	}
+
+	wld_font_text_extents(font, text, &extents);
+	run->font = font;
+	run->width = extents.advance;
+	run->num_renders = 0;
+	wl_list_insert(&text_cache, &run->link);
+
+	if (++text_cache_size > TEXT_CACHE_SIZE)
+		text_run_destroy(wl_container_of(text_cache.prev, run, link));
+
+	return run;
+
+found:
+	wl_list_remove(&run->link);
+	wl_list_insert(&text_cache, &run->link);
+	return run;
+}
+
+/* Get the buffer containing the text run drawn in the given colors, or NULL if
+ * it hasn't been rendered in them. */
+static struct wld_buffer *
+text_run_buffer(struct text_run *run, uint32_t fg, uint32_t bg)
+{
+	unsigned index;
+
+	for (index = 0; index < run->num_renders; ++index) {
+		if (run->renders[index].fg == fg && run->renders[index].bg == bg)
+			return run->renders[index].buffer;
+	}
+
+	return NULL;
+}
+
+/* Render the text run in the given colors if it isn't in the cache yet. This
+ * changes the renderer's target, so it must not happen during a frame. */
+static void
+text_run_render(struct text_run *run, uint32_t fg, uint32_t bg)
+{
+	struct wld_buffer *buffer;
+
+	if (run->width == 0 || text_run_buffer(run, fg, bg))
+		return;
+	if (!(buffer = wld_create_buffer(wld.context, run->width, run->font->height + 2, WLD_FORMAT_XRGB8888, 0)))
+		return;
+
+	wld_set_target_buffer(wld.renderer, buffer);
+	wld_fill_rectangle(wld.renderer, bg, 0, 0, run->width, run->font->height + 2);
+	wld_draw_text(wld.renderer, run->font, fg, 0, run->font->ascent + 1, run->text, -1, NULL);
+	wld_flush(wld.renderer);
+
+	/* Replace the oldest render if there is no room for another one. */
+	if (run->num_renders == ARRAY_LENGTH(run->renders)) {
+		wld_buffer_unreference(run->renders[0].buffer);
+		memmove(&run->renders[0], &run->renders[1], sizeof run->renders - sizeof run->renders[0]);
+		--run->num_renders;
+	}
+
+	run->renders[run->num_renders].fg = fg;
+	run->renders[run->num_renders].bg = bg;
+	run->renders[run->num_renders].buffer = buffer;
+	++run->num_renders;
+}
+
+/* Make sure draw_text can use a cached rendering of the text. */
+static void
+prepare_text(const char *text, bool transient, const struct style *style)
+{
+	struct text_run *run;
+
+	if (!transient && (run = text_run(wld.font, text)))
+		text_run_render(run, style->fg, style->bg);
+}
+
+/* Draw text with its top left corner at x, y, using a cached rendering of it
+ * when possible. */
+static void
+draw_text(struct status_bar *bar, const char *text, bool transient,
+          const struct style *style, uint32_t x, uint32_t y)
+{
+	struct text_run *run;
+	struct wld_buffer *buffer;
+
+	if (transient || !(run = text_run(wld.font, text)) || !(buffer = text_run_buffer(run, style->fg, style->bg))) {
+		wld_draw_text(wld.renderer, wld.font, style->fg, x, y + wld.font->ascent + 1, text, -1, NULL);
+		return;
+	}
+
+	wld_copy_rectangle(wld.renderer, buffer, x, y, 0, 0, run->width, wld.font->height + 2);
+}
+
 static void
 update_text_item_data(struct text_item_data *data)
 {
 	struct wld_extents extents;
+	struct text_run *run;
 
-	wld_font_text_extents(wld.font, data->text, &extents);
-	data->base.width = extents.advance + spacing;
-	need_draw = true;
+	if (!data->transient && (run = text_run(wld.font, data->text))) {
+		data->base.width = run->width + spacing;
+	} else {
+		wld_font_text_extents(wld.font, data->text, &extents);
+		data->base.width = extents.advance + spacing;
+	}
+	++data->base.version;
+}
+
+/* Note that the bar needs to be redrawn because of a velox event. Since version
+ * 2, changes come in batches which end with a done event, so wait for that. */
+static void
+velox_changed(uint32_t version)
+{
+	if (version >= 2)
+		changes_pending = true;
+	else
+		need_draw = true;
 }
 
 /* Wayland event handlers */
@@ -233,6 +435,9 @@ registry_global(void *data, struct wl_registry *registry,
 
 		screen = xmalloc(sizeof *screen);
 		screen->focus_data.text = "";
+		screen->focus_data.transient = true;
+		screen->focus_data.base.width = 0;
+		screen->focus_data.base.version = 0;
 		screen->focus.title = NULL;
 		screen->focus.tag = NULL;
 		screen->swc = wl_registry_bind(registry, name, &swc_screen_interface, 1);
@@ -240,17 +445,19 @@ registry_global(void *data, struct wl_registry *registry,
 			die("Failed to bind swc_screen");
 		wl_list_insert(screens.prev, &screen->link);
 	} else if (strcmp(interface, "velox") == 0) {
-		velox = wl_registry_bind(registry, name, &velox_interface, 1);
+		velox = wl_registry_bind(registry, name, &velox_interface, version < 2 ? version : 2);
 	} else if (strcmp(interface, "velox_tag") == 0) {
 		struct tag *tag;
 
 		tag = xmalloc(sizeof *tag);
 		tag->name = NULL;
 		tag->name_data.text = "";
+		tag->name_data.transient = false;
 		tag->name_data.base.width = 0;
+		tag->name_data.base.version = 0;
 		tag->screen = NULL;
 		tag->num_windows = 0;
-		tag->velox = wl_registry_bind(registry, name, &velox_tag_interface, 1);
+		tag->velox = wl_registry_bind(registry, name, &velox_tag_interface, version < 2 ? version : 2);
 		if (!tag->velox)
 			die("Failed to bind velox_tag");
 		wl_list_insert(tags.prev, &tag->link);
@@ -272,6 +479,19 @@ panel_docked(void *data, struct swc_panel *panel, uint32_t length)
 	bar->height = wld.font->height + 2;
 	bar->wld_surface = wld_wayland_create_surface(wld.context, bar->width, bar->height,
 	                                              WLD_FORMAT_XRGB8888, 0, bar->surface);
+	memset(bar->buffers, 0, sizeof bar->buffers);
+	bar->next_buffer = 0;
+	bar->dirty = true;
+	bar->frame = NULL;
+}
+
+static void
+frame_done(void *data, struct wl_callback *callback, uint32_t time)
+{
+	struct status_bar *bar = data;
+
+	wl_callback_destroy(callback);
+	bar->frame = NULL;
 }
 
 static void
@@ -283,6 +503,7 @@ velox_tag_name(void *data, struct velox_tag *velox_tag, const char *name)
 	tag->name = strdup(name);
 	tag->name_data.text = tag->name;
 	update_text_item_data(&tag->name_data);
+	velox_changed(velox_tag_get_version(velox_tag));
 }
 
 static void
@@ -291,6 +512,8 @@ velox_tag_state(void *data, struct velox_tag *velox_tag, uint32_t num_windows)
 	struct tag *tag = data;
 
 	tag->num_windows = num_windows;
+	++tag->name_data.base.version;
+	velox_changed(velox_tag_get_version(velox_tag));
 }
 
 static void
@@ -299,7 +522,15 @@ velox_tag_screen(void *data, struct velox_tag *velox_tag, struct velox_screen *v
 	struct tag *tag = data;
 
 	tag->screen = velox_screen;
-	need_draw = true;
+	++tag->name_data.base.version;
+	velox_changed(velox_tag_get_version(velox_tag));
+}
+
+static void
+velox_tag_done(void *data, struct velox_tag *velox_tag)
+{
+	need_draw |= changes_pending;
+	changes_pending = false;
 }
 
 static void
@@ -317,18 +548,42 @@ velox_screen_focus(void *data, struct velox_screen *velox_screen, const char *ti
 		title = "";
 	}
 
+	/* The focused tag is marked in the tag items. */
+	if (tag != screen->focus.tag) {
+		if (screen->focus.tag)
+			++((struct tag *)velox_tag_get_user_data(screen->focus.tag))->name_data.base.version;
+		if (tag)
+			++((struct tag *)velox_tag_get_user_data(tag))->name_data.base.version;
+	}
+
 	screen->focus.tag = tag;
 	screen->focus_data.text = title;
 	update_text_item_data(&screen->focus_data);
+	velox_changed(velox_screen_get_version(velox_screen));
+}
+
+static void
+velox_screen_done(void *data, struct velox_screen *velox_screen)
+{
+	need_draw |= changes_pending;
+	changes_pending = false;
 }
 
 /* Item implementations */
+void
+text_prepare(struct status_bar *bar, struct item *item)
+{
+	struct text_item_data *data = (void *)item->data;
+
+	prepare_text(data->text, data->transient, &normal);
+}
+
 void
 text_draw(struct status_bar *bar, struct item *item, uint32_t x, uint32_t y)
 {
 	struct text_item_data *data = (void *)item->data;
 
-	wld_draw_text(wld.renderer, wld.font, normal.fg, x, y + wld.font->ascent + 1, data->text, -1, NULL);
+	draw_text(bar, data->text, data->transient, &normal, x, y);
 }
 
 void
@@ -337,15 +592,33 @@ divider_draw(struct status_bar *bar, struct item *item, uint32_t x, uint32_t y)
 	wld_fill_rectangle(wld.renderer, normal.fg, x + spacing / 2, y, 2, bar->height);
 }
 
+static const struct style *
+tag_style(struct status_bar *bar, struct tag *tag)
+{
+	struct screen *screen = wl_container_of(bar, screen, status_bar);
+
+	return tag->screen == screen->velox ? &selected : &normal;
+}
+
+void
+tag_prepare(struct status_bar *bar, struct item *item)
+{
+	struct tag *tag = wl_container_of(item->data, tag, name_data);
+
+	prepare_text(tag->name_data.text, false, tag_style(bar, tag));
+}
+
 void
 tag_draw(struct status_bar *bar, struct item *item, uint32_t x, uint32_t y)
 {
 	struct tag *tag = wl_container_of(item->data, tag, name_data);
 	struct screen *screen = wl_container_of(bar, screen, status_bar);
-	const struct style *style;
+	const struct style *style = tag_style(bar, tag);
 
-	style = tag->screen == screen->velox ? &selected : &normal;
 	wld_fill_rectangle(wld.renderer, style->bg, x, y, item->data->width, bar->height);
+
+	/* The text is drawn with its background, so the markers go on top. */
+	draw_text(bar, tag->name_data.text, false, style, x + spacing / 2, y);
 	if (tag->num_windows > 0)
 		wld_fill_rectangle(wld.renderer, style->fg, x, y, item->data->width, 1);
 	if (tag->velox == screen->focus.tag) {
@@ -353,23 +626,17 @@ tag_draw(struct status_bar *bar, struct item *item, uint32_t x, uint32_t y)
 		wld_fill_rectangle(wld.renderer, style->fg, x, y + 2, 2, 1);
 		wld_fill_rectangle(wld.renderer, style->fg, x, y + 3, 1, 1);
 	}
-
-	x += spacing / 2;
-	y += wld.font->ascent + 1;
-	wld_draw_text(wld.renderer, wld.font, style->fg, x, y, tag->name_data.text, -1, NULL);
 }
 
 static void
-draw(struct status_bar *bar)
+layout(struct status_bar *bar)
 {
 	struct item *item;
 	uint32_t start_x[3] = {
 		0, bar->width / 2, bar->width
 	};
 	uint32_t x;
-
-	wld_set_target_surface(wld.renderer, bar->wld_surface);
-	wld_fill_rectangle(wld.renderer, normal.bg, 0, 0, bar->width, bar->height);
+	unsigned align;
 
 	wl_list_for_each (item, &bar->items[ALIGN_CENTER], link)
 		start_x[ALIGN_CENTER] -= item->data->width / 2;
@@ -377,25 +644,167 @@ draw(struct status_bar *bar)
 	wl_list_for_each (item, &bar->items[ALIGN_RIGHT], link)
 		start_x[ALIGN_RIGHT] -= item->data->width;
 
-	x = start_x[ALIGN_LEFT];
-	wl_list_for_each (item, &bar->items[ALIGN_LEFT], link) {
-		item->interface->draw(bar, item, x, 0);
-		x += item->data->width;
+	for (align = 0; align < ARRAY_LENGTH(bar->items); ++align) {
+		x = start_x[align];
+		wl_list_for_each (item, &bar->items[align], link) {
+			item->state.x = x;
+			item->state.width = item->data->width;
+			item->state.version = item->data->version;
+			x += item->data->width;
+		}
 	}
+}
+
+/* Find the slot for the buffer we are about to draw into, or claim a new one
+ * if we haven't seen it before, in which case its contents are unknown. */
+static unsigned
+buffer_slot(struct status_bar *bar, struct wld_buffer *buffer, bool *known)
+{
+	struct item *item;
+	unsigned index, align;
 
-	x = start_x[ALIGN_CENTER];
-	wl_list_for_each (item, &bar->items[ALIGN_CENTER], link) {
-		item->interface->draw(bar, item, x, 0);
-		x += item->data->width;
+	for (index = 0; index < MAX_BUFFERS; ++index) {
+		if (bar->buffers[index] == buffer) {
+			*known = true;
+			return index;
+		}
+	}
+
+	index = bar->next_buffer++ % MAX_BUFFERS;
+	bar->buffers[index] = buffer;
+	for (align = 0; align < ARRAY_LENGTH(bar->items); ++align) {
+		wl_list_for_each (item, &bar->items[align], link)
+			memset(&item->drawn[index], 0, sizeof item->drawn[index]);
 	}
+	*known = false;
+
+	return index;
+}
+
+static bool
+state_equal(const struct item_state *a, const struct item_state *b)
+{
+	return a->x == b->x && a->width == b->width && a->version == b->version;
+}
+
+static bool
+overlaps(const struct item_state *a, const struct item_state *b)
+{
+	return a->x < b->x + b->width && b->x < a->x + a->width;
+}
+
+static void
+add_damage(struct item_state *damage, unsigned *num_damage, const struct item_state *state)
+{
+	unsigned index;
+
+	if (state->width == 0)
+		return;
 
-	x = start_x[ALIGN_RIGHT];
-	wl_list_for_each (item, &bar->items[ALIGN_RIGHT], link) {
-		item->interface->draw(bar, item, x, 0);
-		x += item->data->width;
+	for (index = 0; index < *num_damage; ++index) {
+		if (damage[index].x == state->x && damage[index].width == state->width)
+			return;
 	}
 
-	wl_surface_damage(bar->surface, 0, 0, bar->width, bar->height);
+	damage[(*num_damage)++] = *state;
+}
+
+static void
+draw(struct status_bar *bar)
+{
+	struct item *item;
+	struct wld_buffer *buffer;
+	unsigned align, index, num_items = 0, num_damage = 0, num_cleared, i;
+	bool known, redraw;
+
+	bar->dirty = false;
+	layout(bar);
+
+	for (align = 0; align < ARRAY_LENGTH(bar->items); ++align) {
+		wl_list_for_each (item, &bar->items[align], link)
+			++num_items;
+	}
+
+	/* Each item can contribute its old extent in this buffer, its extent in
+	 * the last frame, and its new extent twice: once because it changed and
+	 * once because it was redrawn. */
+	struct item_state damage[4 * num_items + 1];
+	const struct item_state all = { .x = 0, .width = bar->width };
+
+	if (!(buffer = wld_surface_take(bar->wld_surface)))
+		return;
+
+	index = buffer_slot(bar, buffer, &known);
+
+	if (!known) {
+		add_damage(damage, &num_damage, &all);
+	} else {
+		for (align = 0; align < ARRAY_LENGTH(bar->items); ++align) {
+			wl_list_for_each (item, &bar->items[align], link) {
+				/* Repaint what changed since this buffer was drawn, and
+				 * anything that differs from the last frame, which is
+				 * what the compositor has to be told about. */
+				if (!state_equal(&item->state, &item->drawn[index])) {
+					add_damage(damage, &num_damage, &item->drawn[index]);
+					add_damage(damage, &num_damage, &item->state);
+				}
+				if (!state_equal(&item->state, &item->shown))
+					add_damage(damage, &num_damage, &item->shown);
+			}
+		}
+	}
+
+	/* Nothing changed, so don't touch the bar at all. */
+	if (num_damage == 0)
+		return;
+
+	/* Render the text that isn't cached yet before the frame begins, since
+	 * that needs another target. */
+	for (align = 0; align < ARRAY_LENGTH(bar->items); ++align) {
+		wl_list_for_each (item, &bar->items[align], link) {
+			if (!item->interface->prepare)
+				continue;
+			redraw = false;
+			for (i = 0; i < num_damage && !redraw; ++i)
+				redraw = overlaps(&item->state, &damage[i]);
+			if (redraw)
+				item->interface->prepare(bar, item);
+		}
+	}
+
+	wld_set_target_surface(wld.renderer, bar->wld_surface);
+
+	for (i = 0; i < num_damage; ++i)
+		wld_fill_rectangle(wld.renderer, normal.bg, damage[i].x, 0, damage[i].width, bar->height);
+
+	/* Redraw every item that was changed or partly cleared. Items don't
+	 * overlap, so clearing an item's extent only affects that item. */
+	num_cleared = num_damage;
+	for (align = 0; align < ARRAY_LENGTH(bar->items); ++align) {
+		wl_list_for_each (item, &bar->items[align], link) {
+			redraw = false;
+			for (i = 0; i < num_cleared && !redraw; ++i)
+				redraw = overlaps(&item->state, &damage[i]);
+
+			if (redraw) {
+				wld_fill_rectangle(wld.renderer, normal.bg, item->state.x, 0, item->state.width, bar->height);
+				item->interface->draw(bar, item, item->state.x, 0);
+				add_damage(damage, &num_damage, &item->state);
+			}
+
+			item->drawn[index] = item->state;
+			item->shown = item->state;
+		}
+	}
+
+	for (i = 0; i < num_damage; ++i)
+		wl_surface_damage(bar->surface, damage[i].x, 0, damage[i].width, bar->height);
+
+	/* Don't draw again until the compositor has used this frame. It won't
+	 * tell us while the bar isn't visible, so hidden bars aren't drawn. */
+	if ((bar->frame = wl_surface_frame(bar->surface)))
+		wl_callback_add_listener(bar->frame, &frame_listener, bar);
+
 	wld_flush(wld.renderer);
 	wld_swap(bar->wld_surface);
 }
@@ -414,7 +823,8 @@ setup()
 	wl_list_init(&screens);
 	wl_list_init(&tags);
 
-	if (timer_create(CLOCK_MONOTONIC, NULL, &timer) != 0)
+	/* The clock shows the wall clock time, so the timer follows it. */
+	if (timer_create(CLOCK_REALTIME, NULL, &timer) != 0)
 		die("Failed to create timer: %s", strerror(errno));
 
 	if (!(display = wl_display_connect(NULL)))
@@ -504,13 +914,23 @@ setup()
 	wl_display_flush(display);
 }
 
+static void
+update_clock()
+{
+	time_t raw_time = time(NULL);
+	struct tm *local_time = localtime(&raw_time);
+
+	strftime(clock_text, sizeof clock_text, "%A %T %F", local_time);
+	update_text_item_data(&clock_data);
+	need_draw = true;
+}
+
 static void
 run()
 {
 	sigset_t signals;
 	struct itimerspec timer_value = {
 		.it_interval = { 1, 0 },
-		.it_value = { 0, 1 }
 	};
 	struct pollfd fds[2];
 	struct screen *screen;
@@ -524,7 +944,13 @@ run()
 	fds[1].fd = signalfd(-1, &signals, SFD_CLOEXEC);
 	fds[1].events = POLLIN;
 
-	timer_settime(timer, 0, &timer_value, NULL);
+	/* Tick at the start of each second, so the clock changes along with the
+	 * wall clock rather than up to a second behind it. */
+	update_clock();
+	clock_gettime(CLOCK_REALTIME, &timer_value.it_value);
+	timer_value.it_value.tv_sec += 1;
+	timer_value.it_value.tv_nsec = 0;
+	timer_settime(timer, TIMER_ABSTIME, &timer_value, NULL);
 	running = true;
 
 	while (true) {
@@ -539,21 +965,23 @@ run()
 			}
 		}
 		if (fds[1].revents & POLLIN) {
-			time_t raw_time = time(NULL);
-			struct tm *local_time = localtime(&raw_time);
-
 			sigwaitinfo(&signals, NULL);
-
-			strftime(clock_text, sizeof clock_text, "%A %T %F", local_time);
-			update_text_item_data(&clock_data);
+			update_clock();
 		}
 
 		if (need_draw) {
 			wl_list_for_each (screen, &screens, link)
-				draw(&screen->status_bar);
+				screen->status_bar.dirty = true;
 			need_draw = false;
 		}
 
+		/* Draw at most once per frame. Bars that are still waiting for a
+		 * frame callback are drawn once it arrives. */
+		wl_list_for_each (screen, &screens, link) {
+			if (screen->status_bar.dirty && !screen->status_bar.frame)
+				draw(&screen->status_bar);
+		}
+
 		wl_display_flush(display);
 	}
 }
@@ -23,24 +23,114 @@
  */
 
 #include "config.h"
+#include "process.h"
+#include "stats.h"
+#include "trace.h"
 #include "util.h"
 #include "velox.h"
 
 #include <fcntl.h>
+#include <inttypes.h>
 #include <linux/input.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <swc.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 #include <xkbcommon/xkbcommon.h>
 
+/* A pending property assignment from a set command. */
+struct set {
+	struct config_node *node;
+	char *value;
+	struct wl_list link;
+};
+
+/* An action node created by an action command. */
+struct user_action {
+	struct config_node *group, *node;
+	struct wl_list link;
+};
+
+/* A key or button binding from a key or button command. */
+struct binding_config {
+	enum swc_binding_type type;
+	uint32_t mods, value;
+	struct config_node *press, *release;
+	struct wl_list link;
+};
+
+/* The config file is compiled to a cache of the set, action, key, button and
+ * rule commands in it, with the keys and modifiers already resolved. The
+ * cache is a header, followed by the records, followed by a table of
+ * NUL-terminated strings that they refer to by offset. */
+#define CACHE_MAGIC 0x43584c56
+#define CACHE_VERSION 1
+#define CACHE_VALUES 3
+#define CACHE_STRINGS 4
+
+enum cache_command {
+	CACHE_SET,
+	CACHE_ACTION,
+	CACHE_BINDING,
+	CACHE_RULE,
+};
+
+/* The config file a cache was compiled from. It is zeroed before being filled
+ * in, so that it can be compared with memcmp. */
+struct cache_source {
+	char path[256];
+	int64_t mtime_sec, mtime_nsec;
+	uint64_t size;
+	uint32_t hash;
+};
+
+struct cache_header {
+	uint32_t magic, version;
+	struct cache_source source;
+	uint32_t num_records, strings_size;
+	/* The hash of everything after the header. */
+	uint32_t checksum;
+};
+
+struct cache_record {
+	uint32_t command;
+	/* The binding type, modifiers and value, or the rule type and match. */
+	uint32_t values[CACHE_VALUES];
+	/* The identifiers and arguments of the command. */
+	uint32_t strings[CACHE_STRINGS];
+};
+
+/* Everything created by parsing the config file once. All of it is allocated
+ * from the generation's arena, so it is freed at once when the generation is
+ * replaced, or when parsing fails part way through. */
+struct generation {
+	struct arena arena;
+	struct wl_list sets, actions, bindings;
+	struct rules *rules;
+
+	/* The cache records for the commands parsed so far, if the generation is
+	 * being parsed from the config file. */
+	bool recording;
+	struct wl_array records, strings;
+};
+
 static CONFIG_GROUP(root);
-struct wl_list *config_root = &root_group.group;
+struct config_node *config_root = &root_group;
 
 static uint32_t mod = SWC_MOD_LOGO;
 static const char whitespace[] = " \t\n";
 
+/* The generation currently in use, and the one being parsed. */
+static struct generation *current, *next;
+
+/* Memory for config nodes that are never freed. */
+static struct arena permanent;
+
 static bool
 parse_modifier(const char *string, uint32_t *modifier)
 {
@@ -68,44 +158,150 @@ mod_set(struct config_node *node, const char *value)
 	return parse_modifier(value, &mod);
 }
 
-static CONFIG_PROPERTY(mod, &mod_set);
+/* mod is reset whenever a config is parsed, before any of it is read. */
+static CONFIG_PROPERTY(mod, &mod_set, NULL);
 
-static bool
-section_match(const char *p, const char *q)
+void *
+config_alloc(size_t size)
 {
-	for (; *p == *q && *p; ++p, ++q)
-		;
-	return (*p == '.' || *p == '\0') && *q == '\0';
+	return arena_alloc(&permanent, size);
 }
 
-static struct config_node *
-lookup(char *identifier)
-{
-	struct config_node *group_node, *next_group_node, *node;
-	char *section;
-
-	for (group_node = &root_group; group_node; group_node = next_group_node) {
-		section = identifier;
-		identifier += strcspn(identifier, ".");
-		next_group_node = NULL;
-
-		wl_list_for_each (node, &group_node->group, link) {
-			if (section_match(section, node->name)) {
-				if (node->type == CONFIG_NODE_TYPE_GROUP) {
-					if (*identifier == '\0')
-						return NULL;
-					next_group_node = node;
-					++identifier;
-				} else {
-					return *identifier == '\0' ? node : NULL;
-				}
+char *
+config_strdup(const char *s)
+{
+	return arena_strdup(&permanent, s);
+}
 
-				break;
-			}
+bool
+config_add_node(struct config_node *group, struct config_node *node)
+{
+	struct hash_entry *entry;
+	char value[64];
+
+	if (node->type == CONFIG_NODE_TYPE_PROPERTY && node->property.get && !node->property.default_value) {
+		node->property.get(node, value, sizeof value);
+		if (!(node->property.default_value = config_strdup(value)))
+			return false;
+	}
+
+	if (group->group.table.size == 0 && !hash_table_init(&group->group.table))
+		return false;
+
+	if ((entry = hash_table_lookup(&group->group.table, node->name, strlen(node->name))))
+		hash_table_remove(&group->group.table, entry);
+
+	node->entry.key = node->name;
+	if (!hash_table_insert(&group->group.table, &node->entry))
+		return false;
+
+	wl_list_insert(group->group.nodes.prev, &node->link);
+
+	return true;
+}
+
+void
+config_remove_node(struct config_node *group, struct config_node *node)
+{
+	struct hash_entry *entry;
+	struct config_node *other;
+
+	wl_list_remove(&node->link);
+	entry = hash_table_lookup(&group->group.table, node->name, strlen(node->name));
+
+	if (entry != &node->entry)
+		return;
+
+	hash_table_remove(&group->group.table, entry);
+
+	/* Let the most recently added node with the same name take its place. */
+	wl_list_for_each_reverse (other, &group->group.nodes, link) {
+		if (strcmp(other->name, node->name) == 0) {
+			hash_table_insert(&group->group.table, &other->entry);
+			break;
 		}
 	}
+}
 
-	return NULL;
+static struct config_node *
+lookup(const char *identifier)
+{
+	struct config_node *node = &root_group;
+	struct hash_entry *entry;
+	size_t len;
+
+	while (true) {
+		len = strcspn(identifier, ".");
+
+		if (!(entry = hash_table_lookup(&node->group.table, identifier, len)))
+			return NULL;
+
+		node = wl_container_of(entry, node, entry);
+		identifier += len;
+
+		if (*identifier == '\0')
+			return node;
+		if (node->type != CONFIG_NODE_TYPE_GROUP)
+			return NULL;
+
+		++identifier;
+	}
+}
+
+/* Add a command to the cache being compiled. If memory runs out, the config is
+ * still loaded, but no cache is written. */
+static void
+record(enum cache_command command, const uint32_t *values, const char *const *strings)
+{
+	struct cache_record *record;
+	unsigned index;
+	size_t size;
+	char *string;
+
+	if (!next->recording)
+		return;
+
+	if (!(record = wl_array_add(&next->records, sizeof *record)))
+		goto error0;
+
+	record->command = command;
+	for (index = 0; index < CACHE_VALUES; ++index)
+		record->values[index] = values ? values[index] : 0;
+	for (index = 0; index < CACHE_STRINGS; ++index) {
+		size = strings[index] ? strlen(strings[index]) + 1 : 1;
+		record->strings[index] = next->strings.size;
+		if (!(string = wl_array_add(&next->strings, size)))
+			goto error0;
+		memcpy(string, strings[index] ? strings[index] : "", size);
+	}
+
+	return;
+
+error0:
+	next->recording = false;
+}
+
+static bool
+add_set(const char *identifier, const char *value)
+{
+	struct config_node *node;
+	struct set *set;
+
+	if (!(node = lookup(identifier)) || node->type != CONFIG_NODE_TYPE_PROPERTY) {
+		fprintf(stderr, "Unknown identifier '%s'\n", identifier);
+		return false;
+	}
+
+	if (!(set = arena_alloc(&next->arena, sizeof *set)))
+		return false;
+	if (!(set->value = arena_strdup(&next->arena, value)))
+		return false;
+	set->node = node;
+	wl_list_insert(next->sets.prev, &set->link);
+
+	record(CACHE_SET, NULL, (const char *[CACHE_STRINGS]){ identifier, value });
+
+	return true;
 }
 
 static bool
@@ -121,137 +317,161 @@ handle_set(char *s)
 		return false;
 
 	*s++ = '\0';
-
-	if (!(node = lookup(identifier)) || node->type != CONFIG_NODE_TYPE_PROPERTY) {
-		fprintf(stderr, "Unknown identifier '%s'\n", identifier);
-		return false;
-	}
-
 	s += strspn(s, whitespace);
 	value = s;
 	s += strcspn(s, whitespace);
 	*s = '\0';
-	node->property.set(node, value);
 
-	return true;
+	/* The mod property only affects how the rest of the file is parsed, so it
+	 * takes effect immediately, and is already applied to the bindings in the
+	 * cache. Everything else is applied when the whole file has been parsed
+	 * successfully. */
+	if ((node = lookup(identifier)) == &mod_property)
+		return mod_set(node, value);
+
+	return add_set(identifier, value);
 }
 
 struct spawn_action {
 	struct config_node node;
-	char *command;
+	char **argv;
 };
 
 static void
 spawn(struct config_node *node, const struct variant *v)
 {
 	struct spawn_action *action = wl_container_of(node, action, node);
-	int null;
 
-	if (fork() != 0)
-		return;
-	null = open("/dev/null", O_RDWR);
-	if (null < 0 || dup2(null, 0) < 0 || dup2(null, 1) < 0 || dup2(null, 2) < 0 || close(null) < 0)
-		goto fail;
-	execl("/bin/sh", "sh", "-c", action->command, NULL);
-fail:
-	exit(127);
+	process_spawn(action->argv, true);
 }
 
 static struct config_node *
-spawn_action(char *command)
+spawn_action(struct arena *arena, const char *command)
 {
 	struct spawn_action *action;
 
-	if (!(action = malloc(sizeof *action)))
-		goto error0;
+	if (!(action = arena_alloc(arena, sizeof *action)))
+		return NULL;
 
+	action->node.name = NULL;
 	action->node.action.run = &spawn;
-	if (!(action->command = strdup(command)))
-		goto error1;
+	if (!(action->argv = process_argv(arena, command)))
+		return NULL;
 
 	return &action->node;
-
-error1:
-	free(action);
-error0:
-	return NULL;
 }
 
 struct {
 	const char *name;
-	struct config_node *(*create_action)(char *arguments);
+	struct config_node *(*create_action)(struct arena *arena, const char *arguments);
 } action_types[] = {
 	{ "spawn", &spawn_action }
 };
 
 static bool
-handle_action(char *s)
+add_action(const char *group_identifier, const char *name, const char *type, const char *arguments)
 {
-	char *identifier, *name, *type;
 	unsigned index;
 	struct config_node *node, *group_node;
+	struct user_action *action;
+
+	if (!*group_identifier) {
+		group_node = &root_group;
+	} else if (!(group_node = lookup(group_identifier)) || group_node->type != CONFIG_NODE_TYPE_GROUP) {
+		fprintf(stderr, "Invalid group identifier '%s'\n", group_identifier);
+		return false;
+	}
+
+	for (index = 0; index < ARRAY_LENGTH(action_types); ++index) {
+		if (strcmp(type, action_types[index].name) == 0)
+			goto found;
+	}
+
+	fprintf(stderr, "Unknown action type '%s'\n", type);
+	return false;
+
+found:
+	if (!(action = arena_alloc(&next->arena, sizeof *action)))
+		return false;
+
+	if (!(node = action_types[index].create_action(&next->arena, arguments))) {
+		fprintf(stderr, "Failed to create action '%s'\n", name);
+		return false;
+	}
+
+	action->group = group_node;
+	action->node = node;
+
+	if (!(node->name = arena_strdup(&next->arena, name)))
+		return false;
+	node->type = CONFIG_NODE_TYPE_ACTION;
+	if (!config_add_node(group_node, node))
+		return false;
+	wl_list_insert(next->actions.prev, &action->link);
+
+	record(CACHE_ACTION, NULL, (const char *[CACHE_STRINGS]){ group_identifier, name, type, arguments });
+
+	return true;
+}
+
+static bool
+handle_action(char *s)
+{
+	char *identifier, *name, *type;
 
 	if (!(identifier = strtok_r(s, whitespace, &s))) {
 		fprintf(stderr, "No action identifier specified\n");
-		goto error0;
+		return false;
 	}
 
-	name = strrchr(identifier, '.');
-
-	if (name) {
+	if ((name = strrchr(identifier, '.'))) {
 		*name++ = '\0';
-
-		if (!(group_node = lookup(identifier))) {
-			fprintf(stderr, "Invalid group identifier '%s'\n", identifier);
-			goto error0;
-		}
 	} else {
 		name = identifier;
-		group_node = &root_group;
+		identifier = "";
 	}
 
 	if (!(type = strtok_r(NULL, whitespace, &s))) {
 		fprintf(stderr, "No action type specified\n");
-		goto error0;
+		return false;
 	}
 
 	s += strspn(s, whitespace);
 
-	for (index = 0; index < ARRAY_LENGTH(action_types); ++index) {
-		if (strcmp(type, action_types[index].name) == 0) {
-			if (!(node = action_types[index].create_action(s))) {
-				fprintf(stderr, "Failed to create action '%s'\n", name);
-				goto error0;
-			}
-
-			if (!(node->name = strdup(name)))
-				goto error1;
-			node->type = CONFIG_NODE_TYPE_ACTION;
-			wl_list_insert(&group_node->group, &node->link);
-		}
-	}
-
-	return true;
-
-error1:
-	free(node);
-error0:
-	return false;
+	return add_action(identifier, name, type, s);
 }
 
+/* A binding registered with swc. swc has no way to remove a binding, so these
+ * stay registered for the lifetime of the compositor, and each generation
+ * only changes the actions they invoke. */
 struct binding {
 	struct config_node *press, *release;
+	struct hash_entry entry;
+	char key[32];
 };
 
+static struct hash_table bindings;
+
+static void
+run_binding_action(struct config_node *node)
+{
+	uint64_t start = stats_now();
+
+	node->action.run(node, NULL);
+	stats_record(STATS_ACTION, start);
+}
+
 static void
 key_binding(void *data, uint32_t time, uint32_t value, uint32_t state)
 {
 	struct binding *binding = data;
 
+	trace_begin("key_binding");
 	if (state == WL_KEYBOARD_KEY_STATE_PRESSED && binding->press)
-		binding->press->action.run(binding->press, NULL);
+		run_binding_action(binding->press);
 	else if (binding->release)
-		binding->release->action.run(binding->release, NULL);
+		run_binding_action(binding->release);
+	trace_end("key_binding");
 }
 
 static void
@@ -259,10 +479,12 @@ button_binding(void *data, uint32_t time, uint32_t value, uint32_t state)
 {
 	struct binding *binding = data;
 
+	trace_begin("button_binding");
 	if (state == WL_POINTER_BUTTON_STATE_PRESSED && binding->press)
-		binding->press->action.run(binding->press, NULL);
+		run_binding_action(binding->press);
 	else if (binding->release)
-		binding->release->action.run(binding->release, NULL);
+		run_binding_action(binding->release);
+	trace_end("button_binding");
 }
 
 static void (*binding_handler[])(void *, uint32_t, uint32_t, uint32_t) = {
@@ -270,6 +492,39 @@ static void (*binding_handler[])(void *, uint32_t, uint32_t, uint32_t) = {
 	[SWC_BINDING_BUTTON] = &button_binding
 };
 
+static struct binding *
+get_binding(enum swc_binding_type type, uint32_t mods, uint32_t value)
+{
+	struct binding *binding;
+	struct hash_entry *entry;
+	char key[sizeof binding->key];
+	int len;
+
+	len = snprintf(key, sizeof key, "%d:%" PRIx32 ":%" PRIx32, type, mods, value);
+
+	if ((entry = hash_table_lookup(&bindings, key, len)))
+		return wl_container_of(entry, binding, entry);
+
+	if (!(binding = config_alloc(sizeof *binding)))
+		return NULL;
+
+	memcpy(binding->key, key, len + 1);
+	binding->entry.key = binding->key;
+	binding->press = NULL;
+	binding->release = NULL;
+
+	/* swc keeps the binding once it is added, so it must already be in the
+	 * table for later generations to find it. */
+	if (!hash_table_insert(&bindings, &binding->entry))
+		return NULL;
+	if (swc_add_binding(type, mods, value, binding_handler[type], binding) < 0) {
+		hash_table_remove(&bindings, &binding->entry);
+		return NULL;
+	}
+
+	return binding;
+}
+
 static bool
 parse_key(char *s, uint32_t *value)
 {
@@ -308,7 +563,7 @@ static bool (*parse_value[])(char *, uint32_t *) = {
 };
 
 static bool
-parse_action(char *s, struct config_node **node)
+parse_action(const char *s, struct config_node **node)
 {
 	if (*s == '\0') {
 		*node = NULL;
@@ -319,17 +574,48 @@ parse_action(char *s, struct config_node **node)
 }
 
 static bool
-handle_binding(enum swc_binding_type type, char *s)
+add_binding(enum swc_binding_type type, uint32_t mods, uint32_t value,
+            const char *press_identifier, const char *release_identifier)
 {
-	char *value_string, *mod_string, *mods_string, *actions_string, *action_identifier;
-	uint32_t value, mod, mods;
-	struct binding *binding;
+	struct config_node *press, *release;
+	struct binding_config *binding;
+
+	/* Lookup press action (if present) */
+	if (!parse_action(press_identifier, &press)) {
+		fprintf(stderr, "Could not find action '%s'\n", press_identifier);
+		return false;
+	}
+
+	/* Lookup release action (if present) */
+	if (!parse_action(release_identifier, &release)) {
+		fprintf(stderr, "Could not find action '%s'\n", release_identifier);
+		return false;
+	}
 
-	if (!(binding = malloc(sizeof *binding))) {
+	if (!(binding = arena_alloc(&next->arena, sizeof *binding))) {
 		fprintf(stderr, "Failed to allocate binding\n");
 		return false;
 	}
 
+	binding->type = type;
+	binding->mods = mods;
+	binding->value = value;
+	binding->press = press;
+	binding->release = release;
+	wl_list_insert(next->bindings.prev, &binding->link);
+
+	record(CACHE_BINDING, (uint32_t[CACHE_VALUES]){ type, mods, value },
+	       (const char *[CACHE_STRINGS]){ press_identifier, release_identifier });
+
+	return true;
+}
+
+static bool
+handle_binding(enum swc_binding_type type, char *s)
+{
+	char *value_string, *mod_string, *mods_string, *actions_string, *press_identifier;
+	uint32_t value, mod, mods;
+
 	if (!(value_string = strtok_r(s, whitespace, &s))) {
 		fprintf(stderr, "No key specified\n");
 		return false;
@@ -360,29 +646,13 @@ handle_binding(enum swc_binding_type type, char *s)
 		return false;
 	}
 
-	action_identifier = actions_string;
+	press_identifier = actions_string;
 	actions_string += strcspn(actions_string, ":");
 
 	if (*actions_string != '\0')
 		*actions_string++ = '\0';
 
-	/* Lookup press action (if present) */
-	if (!parse_action(action_identifier, &binding->press)) {
-		fprintf(stderr, "Could not find action '%s'\n", action_identifier);
-		return false;
-	}
-
-	action_identifier = actions_string;
-
-	/* Lookup release action (if present) */
-	if (!parse_action(action_identifier, &binding->release)) {
-		fprintf(stderr, "Could not find action '%s'\n", action_identifier);
-		return false;
-	}
-
-	swc_add_binding(type, mods, value, binding_handler[type], binding);
-
-	return true;
+	return add_binding(type, mods, value, press_identifier, actions_string);
 }
 
 static bool
@@ -398,15 +668,40 @@ handle_button(char *s)
 }
 
 static bool
-handle_rule(char *s)
+add_rule(enum rule_type type, enum rule_match match, const char *identifier, const char *action_identifier)
 {
-	char *identifier, *type;
 	struct rule *rule;
 	struct config_node *action;
 
+	if (!(action = lookup(action_identifier)) || action->type != CONFIG_NODE_TYPE_ACTION) {
+		fprintf(stderr, "Could not find action '%s'\n", action_identifier);
+		return false;
+	}
+
+	if (!(rule = rule_new(&next->arena, type, match, identifier, action)))
+		return false;
+
+	if (!rules_add(next->rules, rule)) {
+		rule_destroy(rule);
+		return false;
+	}
+
+	record(CACHE_RULE, (uint32_t[CACHE_VALUES]){ type, match },
+	       (const char *[CACHE_STRINGS]){ identifier, action_identifier });
+
+	return true;
+}
+
+static bool
+handle_rule(char *s)
+{
+	char *identifier, *type, *match;
+	enum rule_type rule_type;
+	enum rule_match rule_match;
+
 	if (!(type = strtok_r(s, whitespace, &s))) {
 		fprintf(stderr, "No rule type specified\n");
-		goto error0;
+		return false;
 	}
 
 	s += strspn(s, whitespace);
@@ -415,13 +710,13 @@ handle_rule(char *s)
 		identifier = ++s;
 		if (!(s = strchr(s, '"'))) {
 			fprintf(stderr, "No closing quote found\n");
-			goto error0;
+			return false;
 		}
 		*s++ = '\0';
 		break;
 	case '\0':
 		fprintf(stderr, "No identifier specified\n");
-		goto error0;
+		return false;
 	default:
 		identifier = s;
 		s += strcspn(s, whitespace);
@@ -431,41 +726,37 @@ handle_rule(char *s)
 
 	if (!*s) {
 		fprintf(stderr, "No action specified\n");
-		goto error0;
+		return false;
 	}
 
 	s += strspn(s, whitespace);
 
-	if (!(action = lookup(s)) || action->type != CONFIG_NODE_TYPE_ACTION) {
-		fprintf(stderr, "Could not find action '%s'\n", s);
-		goto error0;
-	}
-
-	if (!(rule = malloc(sizeof *rule)))
-		goto error0;
+	/* The type may be followed by the kind of match, for example title:glob. */
+	match = type + strcspn(type, ":");
+	if (*match != '\0')
+		*match++ = '\0';
 
 	if (strcmp(type, "title") == 0) {
-		rule->type = RULE_TYPE_WINDOW_TITLE;
+		rule_type = RULE_TYPE_WINDOW_TITLE;
 	} else if (strcmp(type, "app_id") == 0) {
-		rule->type = RULE_TYPE_APP_ID;
+		rule_type = RULE_TYPE_APP_ID;
 	} else {
 		fprintf(stderr, "Unknown type '%s'\n", type);
-		goto error1;
+		return false;
 	}
 
-	if (!(rule->identifier = strdup(identifier))) {
-		goto error1;
+	if (*match == '\0' || strcmp(match, "exact") == 0) {
+		rule_match = RULE_MATCH_EXACT;
+	} else if (strcmp(match, "glob") == 0) {
+		rule_match = RULE_MATCH_GLOB;
+	} else if (strcmp(match, "regex") == 0) {
+		rule_match = RULE_MATCH_REGEX;
+	} else {
+		fprintf(stderr, "Unknown match '%s'\n", match);
+		return false;
 	}
 
-	rule->action = action;
-	wl_list_insert(&velox.rules, &rule->link);
-
-	return true;
-
-error1:
-	free(rule);
-error0:
-	return false;
+	return add_rule(rule_type, rule_match, identifier, s);
 }
 
 static const struct {
@@ -495,18 +786,61 @@ config_set_unsigned(unsigned *value, const char *string, int base)
 	return true;
 }
 
+void
+config_get_unsigned(char *value, size_t size, unsigned number, int base)
+{
+	snprintf(value, size, base == 16 ? "%x" : "%u", number);
+}
+
+bool
+config_run_command(char *s)
+{
+	struct config_node *node;
+	char *command, *identifier, *value;
+
+	if (!(command = strtok_r(s, whitespace, &s)) || !(identifier = strtok_r(NULL, whitespace, &s))) {
+		fprintf(stderr, "Incomplete command\n");
+		return false;
+	}
+
+	if (strcmp(command, "run") == 0) {
+		if (!(node = lookup(identifier)) || node->type != CONFIG_NODE_TYPE_ACTION) {
+			fprintf(stderr, "Unknown action '%s'\n", identifier);
+			return false;
+		}
+
+		run_binding_action(node);
+		return true;
+	}
+
+	if (strcmp(command, "set") == 0) {
+		if (!(node = lookup(identifier)) || node->type != CONFIG_NODE_TYPE_PROPERTY) {
+			fprintf(stderr, "Unknown identifier '%s'\n", identifier);
+			return false;
+		}
+		if (!(value = strtok_r(NULL, whitespace, &s))) {
+			fprintf(stderr, "No value specified for '%s'\n", identifier);
+			return false;
+		}
+
+		return node->property.set(node, value);
+	}
+
+	fprintf(stderr, "Unknown command '%s'\n", command);
+	return false;
+}
+
 static FILE *
-open_config()
+open_config(char path[static 256])
 {
 	FILE *file;
-	char path[256];
 
-	snprintf(path, sizeof path, "%s/.velox.conf", getenv("HOME"));
+	snprintf(path, 256, "%s/.velox.conf", getenv("HOME"));
 
 	if ((file = fopen(path, "r")))
 		goto found;
 
-	strcpy(path, "/etc/velox.conf");
+	snprintf(path, 256, "/etc/velox.conf");
 
 	if ((file = fopen(path, "r")))
 		goto found;
@@ -520,21 +854,84 @@ found:
 	return file;
 }
 
-bool
-config_parse()
+static struct generation *
+generation_new()
+{
+	struct generation *generation;
+
+	if (!(generation = malloc(sizeof *generation)))
+		goto error0;
+
+	arena_init(&generation->arena);
+
+	if (!(generation->rules = rules_new(&generation->arena)))
+		goto error1;
+
+	wl_list_init(&generation->sets);
+	wl_list_init(&generation->actions);
+	wl_list_init(&generation->bindings);
+	generation->recording = false;
+	wl_array_init(&generation->records);
+	wl_array_init(&generation->strings);
+
+	return generation;
+
+error1:
+	arena_finish(&generation->arena);
+	free(generation);
+error0:
+	return NULL;
+}
+
+static void
+remove_actions(struct generation *generation)
+{
+	struct user_action *action;
+
+	wl_list_for_each (action, &generation->actions, link)
+		config_remove_node(action->group, action->node);
+}
+
+static void
+add_actions(struct generation *generation)
+{
+	struct user_action *action;
+
+	wl_list_for_each (action, &generation->actions, link)
+		config_add_node(action->group, action->node);
+}
+
+/* Free a generation whose actions are no longer in the config tree. */
+static void
+generation_destroy(struct generation *generation)
+{
+	wl_array_release(&generation->records);
+	wl_array_release(&generation->strings);
+	rules_destroy(generation->rules);
+	arena_finish(&generation->arena);
+	free(generation);
+}
+
+/* Throw away the generation being parsed, and put the current user actions
+ * back. */
+static void
+discard()
+{
+	remove_actions(next);
+	if (current)
+		add_actions(current);
+	generation_destroy(next);
+	next = NULL;
+}
+
+static bool
+parse(FILE *file)
 {
-	FILE *file;
 	char *line = NULL, *s, *command_name;
 	unsigned index;
-	bool handled;
 	size_t size;
 	ssize_t len;
 
-	wl_list_insert(&root_group.group, &mod_property.link);
-
-	if (!(file = open_config()))
-		goto error0;
-
 	while ((len = getline(&line, &size, file)) != -1) {
 		if (line[len - 1] == '\n')
 			line[len - 1] = '\0';
@@ -547,29 +944,466 @@ config_parse()
 		s += strcspn(s, whitespace);
 
 		if (!*s)
-			goto error1;
+			goto error0;
 
 		*s++ = '\0';
-		handled = false;
 
 		for (index = 0; index < ARRAY_LENGTH(commands); ++index) {
-			if (strcmp(commands[index].name, command_name) == 0) {
-				if (!commands[index].handle(s))
-					goto error1;
-				handled = true;
+			if (strcmp(commands[index].name, command_name) == 0)
 				break;
-			}
 		}
 
-		if (!handled)
-			goto error1;
+		if (index == ARRAY_LENGTH(commands)) {
+			fprintf(stderr, "Unknown command '%s'\n", command_name);
+			goto error0;
+		}
+
+		if (!commands[index].handle(s))
+			goto error0;
+	}
+
+	free(line);
+	return true;
+
+error0:
+	free(line);
+	return false;
+}
+
+static bool
+generation_sets(struct generation *generation, struct config_node *node)
+{
+	struct set *set;
+
+	wl_list_for_each (set, &generation->sets, link) {
+		if (set->node == node)
+			return true;
+	}
+
+	return false;
+}
+
+/* Switch over to the newly parsed generation. */
+static void
+commit()
+{
+	struct hash_entry *entry;
+	struct binding *binding;
+	struct binding_config *config;
+	struct set *set;
+	unsigned index;
+
+	/* Properties that were set by the current config, but aren't by the new
+	 * one, go back to their defaults. */
+	if (current) {
+		wl_list_for_each (set, &current->sets, link) {
+			if (set->node->property.default_value && !generation_sets(next, set->node))
+				set->node->property.set(set->node, set->node->property.default_value);
+		}
+	}
+
+	wl_list_for_each (set, &next->sets, link) {
+		if (!set->node->property.set(set->node, set->value))
+			fprintf(stderr, "Invalid value '%s' for property '%s'\n", set->value, set->node->name);
+	}
+
+	/* Clear all the registered bindings, then point the ones that are still
+	 * configured to their new actions. */
+	for (index = 0; index < bindings.size; ++index) {
+		for (entry = bindings.buckets[index]; entry; entry = entry->next) {
+			binding = wl_container_of(entry, binding, entry);
+			binding->press = NULL;
+			binding->release = NULL;
+		}
+	}
+
+	wl_list_for_each (config, &next->bindings, link) {
+		if (!(binding = get_binding(config->type, config->mods, config->value))) {
+			fprintf(stderr, "Failed to add binding\n");
+			continue;
+		}
+
+		binding->press = config->press;
+		binding->release = config->release;
+	}
+
+	velox.rules = next->rules;
+
+	if (current)
+		generation_destroy(current);
+	current = next;
+	next = NULL;
+
+	/* Properties such as the border width affect the layout. */
+	arrange();
+}
+
+/* Start a new generation. The current user actions are taken out of the config
+ * tree while it is built, so that it can't refer to them. */
+static bool
+begin()
+{
+	if (!(next = generation_new()))
+		return false;
+
+	mod = SWC_MOD_LOGO;
+	if (current)
+		remove_actions(current);
+
+	return true;
+}
+
+static bool
+identify(FILE *file, const char *path, struct cache_source *source)
+{
+	struct stat info;
+	char *contents;
+	bool success = false;
+
+	memset(source, 0, sizeof *source);
+
+	if (fstat(fileno(file), &info) == -1)
+		goto error0;
+	if (snprintf(source->path, sizeof source->path, "%s", path) >= sizeof source->path)
+		goto error0;
+
+	source->mtime_sec = info.st_mtim.tv_sec;
+	source->mtime_nsec = info.st_mtim.tv_nsec;
+	source->size = info.st_size;
+
+	/* The modification time alone could miss an edit made within its
+	 * resolution, so the contents are hashed too. */
+	if (!(contents = malloc(info.st_size + 1)))
+		goto error0;
+	if (fread(contents, 1, info.st_size, file) != info.st_size)
+		goto error1;
+
+	source->hash = hash_string(contents, info.st_size);
+	success = true;
+
+error1:
+	free(contents);
+	rewind(file);
+error0:
+	return success;
+}
+
+static bool
+cache_path(char *path, size_t size, bool create)
+{
+	const char *directory;
+	int length;
+	char *slash;
+
+	if ((directory = getenv("XDG_CACHE_HOME")) && *directory)
+		length = snprintf(path, size, "%s/velox", directory);
+	else if ((directory = getenv("HOME")))
+		length = snprintf(path, size, "%s/.cache/velox", directory);
+	else
+		return false;
+
+	if (length < 0 || length + sizeof "/config" > size)
+		return false;
+
+	/* Create each missing directory along the way. */
+	if (create) {
+		for (slash = strchr(path + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+			*slash = '\0';
+			mkdir(path, 0700);
+			*slash = '/';
+		}
+		mkdir(path, 0700);
+	}
+
+	strcat(path, "/config");
+
+	return true;
+}
+
+static void
+store_cache(const struct cache_source *source)
+{
+	struct cache_header header;
+	char path[256], temporary[sizeof path + 8];
+	FILE *file;
+	int fd;
+	bool error;
+
+	if (!next->recording)
+		goto done;
+
+	/* The source is copied with its padding, so that it compares equal. */
+	memset(&header, 0, sizeof header);
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	memcpy(&header.source, source, sizeof header.source);
+	header.num_records = next->records.size / sizeof(struct cache_record);
+	header.strings_size = next->strings.size;
+	header.checksum = hash_string(next->records.data, next->records.size)
+	                ^ hash_string(next->strings.data, next->strings.size);
+
+	if (!cache_path(path, sizeof path, true))
+		goto error0;
+
+	/* Write the cache to a temporary file first, so that a partial one is never
+	 * read. */
+	snprintf(temporary, sizeof temporary, "%s.XXXXXX", path);
+
+	if ((fd = mkstemp(temporary)) == -1)
+		goto error0;
+
+	if (!(file = fdopen(fd, "w"))) {
+		close(fd);
+		goto error1;
+	}
+
+	fwrite(&header, sizeof header, 1, file);
+	fwrite(next->records.data, 1, next->records.size, file);
+	fwrite(next->strings.data, 1, next->strings.size, file);
+
+	error = ferror(file);
+
+	if (fclose(file) != 0 || error || rename(temporary, path) == -1)
+		goto error1;
+
+	goto done;
+
+error1:
+	unlink(temporary);
+error0:
+	fprintf(stderr, "Could not write config cache\n");
+done:
+	next->recording = false;
+	wl_array_release(&next->records);
+	wl_array_release(&next->strings);
+	wl_array_init(&next->records);
+	wl_array_init(&next->strings);
+}
+
+/* Build the next generation from the records of a cache. The whole cache is
+ * checked before anything in it is trusted. */
+static bool
+replay(const struct cache_header *header, size_t size)
+{
+	const struct cache_record *records = (const void *)(header + 1), *record;
+	const char *strings, *string[CACHE_STRINGS];
+	unsigned index;
+	bool success;
+
+	if (header->num_records > (size - sizeof *header) / sizeof *record)
+		return false;
+
+	strings = (const char *)(records + header->num_records);
+
+	if (header->strings_size == 0 || header->strings_size != size - (strings - (const char *)header)
+	    || strings[header->strings_size - 1] != '\0')
+		return false;
+
+	if (header->checksum != (hash_string((const char *)records, strings - (const char *)records)
+	                         ^ hash_string(strings, header->strings_size)))
+		return false;
+
+	for (record = records; record < records + header->num_records; ++record) {
+		for (index = 0; index < CACHE_STRINGS; ++index) {
+			if (record->strings[index] >= header->strings_size)
+				return false;
+			string[index] = strings + record->strings[index];
+		}
+
+		switch (record->command) {
+		case CACHE_SET:
+			success = add_set(string[0], string[1]);
+			break;
+		case CACHE_ACTION:
+			success = add_action(string[0], string[1], string[2], string[3]);
+			break;
+		case CACHE_BINDING:
+			success = record->values[0] < ARRAY_LENGTH(binding_handler)
+			       && add_binding(record->values[0], record->values[1], record->values[2], string[0], string[1]);
+			break;
+		case CACHE_RULE:
+			success = record->values[0] < NUM_RULE_TYPES && record->values[1] <= RULE_MATCH_REGEX
+			       && add_rule(record->values[0], record->values[1], string[0], string[1]);
+			break;
+		default:
+			success = false;
+		}
+
+		if (!success)
+			return false;
 	}
 
-	fclose(file);
 	return true;
+}
+
+static bool
+load_cache(const struct cache_source *source)
+{
+	const struct cache_header *header;
+	struct stat info;
+	char path[256];
+	int fd;
+	bool success = false;
+
+	if (!cache_path(path, sizeof path, false))
+		goto error0;
+
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1)
+		goto error0;
+
+	if (fstat(fd, &info) == -1 || info.st_size < sizeof *header)
+		goto error1;
+
+	if ((header = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+		goto error1;
+
+	if (header->magic != CACHE_MAGIC || header->version != CACHE_VERSION
+	    || memcmp(&header->source, source, sizeof *source) != 0)
+		goto error2;
+
+	if (!begin())
+		goto error2;
+
+	/* Anything the cache refers to that no longer exists, such as an action
+	 * from an older velox, makes it stale. */
+	if (!(success = replay(header, info.st_size)))
+		discard();
+
+error2:
+	munmap((void *)header, info.st_size);
+error1:
+	close(fd);
+error0:
+	return success;
+}
+
+/* Parse the config file into the next generation, or build it from the cache
+ * if that was compiled from the same file. This only uses the config tree and
+ * the new generation, so at startup it runs on another thread while swc is
+ * initialized. */
+static bool
+prepare()
+{
+	struct cache_source source;
+	char path[256];
+	FILE *file;
+	bool identified, success;
+
+	if (!(file = open_config(path)))
+		goto error0;
+
+	if ((identified = identify(file, path, &source)) && load_cache(&source)) {
+		fprintf(stderr, "Using cached config\n");
+		fclose(file);
+		return true;
+	}
+
+	if (!begin())
+		goto error1;
+
+	next->recording = identified;
+
+	if ((success = parse(file)))
+		store_cache(&source);
+	else
+		discard();
+
+	fclose(file);
+
+	return success;
 
 error1:
 	fclose(file);
 error0:
 	return false;
 }
+
+static bool
+load()
+{
+	struct timespec start;
+	bool success;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	if ((success = prepare()))
+		commit();
+
+	fprintf(stderr, "%s config in %.3f ms\n", success ? "Loaded" : "Failed to load", elapsed_ms(&start));
+
+	return success;
+}
+
+/* The initial parse, which runs on the parser thread if it could be
+ * started. */
+static pthread_t parser;
+static bool threaded, parsed;
+static struct timespec parse_start;
+static double parse_time;
+
+static void *
+run_parser(void *data)
+{
+	parsed = prepare();
+	parse_time = elapsed_ms(&parse_start);
+
+	return NULL;
+}
+
+bool
+config_parse_start()
+{
+	if (!hash_table_init(&bindings))
+		return false;
+
+	config_add_node(&root_group, &mod_property);
+	clock_gettime(CLOCK_MONOTONIC, &parse_start);
+
+	threaded = thread_create(&parser, &run_parser, NULL) == 0;
+
+	if (!threaded) {
+		fprintf(stderr, "Could not start config parser thread\n");
+		run_parser(NULL);
+	}
+
+	return true;
+}
+
+static void
+wait_for_parser()
+{
+	if (threaded)
+		pthread_join(parser, NULL);
+	threaded = false;
+}
+
+bool
+config_parse_finish()
+{
+	wait_for_parser();
+
+	if (!parsed) {
+		fprintf(stderr, "Failed to load config in %.3f ms\n", parse_time);
+		return false;
+	}
+
+	commit();
+	fprintf(stderr, "Loaded config in %.3f ms, %.3f ms of it parsing\n", elapsed_ms(&parse_start), parse_time);
+
+	return true;
+}
+
+void
+config_parse_cancel()
+{
+	wait_for_parser();
+
+	if (parsed)
+		discard();
+}
+
+bool
+config_reload()
+{
+	return load();
+}
@@ -24,6 +24,8 @@
 #ifndef VELOX_CONFIG_H
 #define VELOX_CONFIG_H
 
+#include "util.h"
+
 #include <stdbool.h>
 #include <wayland-util.h>
 
@@ -47,9 +49,19 @@ struct config_node {
 	enum config_node_type type;
 
 	union {
-		struct wl_list group;
+		struct {
+			/* The child nodes in registration order, and indexed by name. */
+			struct wl_list nodes;
+			struct hash_table table;
+		} group;
 		struct {
 			bool (*set)(struct config_node *node, const char *value);
+			/* Write the current value to a buffer of the given size. May be
+			 * NULL if the property is never reset. */
+			void (*get)(struct config_node *node, char *value, size_t size);
+			/* The value when the property was registered, which it goes
+			 * back to when a new config no longer sets it. */
+			const char *default_value;
 		} property;
 		struct {
 			void (*run)(struct config_node *node, const struct variant *v);
@@ -57,19 +69,20 @@ struct config_node {
 	};
 
 	struct wl_list link;
+	struct hash_entry entry;
 };
 
 #define CONFIG_GROUP(n) \
 	struct config_node n##_group = { \
 		.name = #n, \
 		.type = CONFIG_NODE_TYPE_GROUP, \
-		.group = { &n##_group.group, &n##_group.group } \
+		.group = { .nodes = { &n##_group.group.nodes, &n##_group.group.nodes } } \
 	}
-#define CONFIG_PROPERTY(n, func) \
+#define CONFIG_PROPERTY(n, set_func, get_func) \
 	struct config_node n##_property = { \
 		.name = #n, \
 		.type = CONFIG_NODE_TYPE_PROPERTY, \
-		.property = { .set = func } \
+		.property = { .set = set_func, .get = get_func } \
 	}
 #define CONFIG_ACTION(n, func) \
 	struct config_node n##_action = { \
@@ -78,9 +91,54 @@ struct config_node {
 		.action = { .run = func } \
 	}
 
-bool config_parse();
+/**
+ * Start parsing the config file on another thread. Nothing else may use the
+ * config tree until config_parse_finish or config_parse_cancel is called.
+ */
+bool config_parse_start();
+
+/**
+ * Wait for the config file to be parsed, and apply it if it succeeded. This
+ * registers the bindings with swc, so swc must be initialized.
+ */
+bool config_parse_finish();
+
+/**
+ * Wait for the config file to be parsed, and throw the result away. This does
+ * nothing after config_parse_finish.
+ */
+void config_parse_cancel();
+
+/**
+ * Parse the config file again, replacing the current bindings, rules and
+ * actions if it succeeds. On failure the current config is kept.
+ */
+bool config_reload();
+
+/**
+ * Run a command sent by a client, either "run <action>" or
+ * "set <property> <value>". The string is modified.
+ */
+bool config_run_command(char *command);
+
 bool config_set_unsigned(unsigned *value, const char *string, int base);
+void config_get_unsigned(char *value, size_t size, unsigned number, int base);
+
+/**
+ * Add a node to a group.
+ *
+ * The group's node list must have been initialized. If the group already has
+ * a node with the same name, the new node shadows it in lookups.
+ */
+bool config_add_node(struct config_node *group, struct config_node *node);
+void config_remove_node(struct config_node *group, struct config_node *node);
+
+/**
+ * Allocate memory for config nodes that live as long as the config tree.
+ */
+void *config_alloc(size_t size);
+char *config_strdup(const char *s);
 
-extern struct wl_list *config_root;
+extern struct config_node *config_root;
 
 #endif
@@ -34,133 +34,104 @@
 const unsigned master_max = 16;
 
 struct layout_impl {
-	void (*begin)(struct layout *layout, const struct swc_rectangle *area, unsigned num_windows);
-	void (*arrange)(struct layout *layout, struct window *window);
-};
-
-struct col {
-	struct swc_rectangle tile;
-	const struct swc_rectangle *area;
-	unsigned num_rows, row_index;
-	void (*next)(struct col *col);
-};
-
-struct grid {
-	struct col col;
-	unsigned num_windows, num_cols, col_index;
+	bool (*arrange_all)(struct layout *layout, const struct swc_rectangle *area, unsigned border_width,
+	                    struct window *const *windows, unsigned num_windows, struct swc_rectangle *rects);
+	/* Whether every tile covers the others, so that only one needs to be
+	 * shown. */
+	bool occludes;
 };
 
 struct tall_layout {
 	struct layout base;
 	unsigned num_masters, num_columns, master_size;
-	struct grid grid;
-	struct swc_rectangle grid_area;
-};
-
-struct grid_layout {
-	struct layout base;
-	struct grid grid;
 };
 
-static void
-tile(struct col *col, struct window *window)
+/* Smallest n such that n * n >= value. Window counts are small, so counting
+ * up is cheap enough. */
+static unsigned
+ceil_sqrt(unsigned value)
 {
-	col->tile.y = col->area->y + border_width + col->row_index * col->area->height / col->num_rows;
-	swc_window_set_geometry(window->swc, &col->tile);
+	unsigned root = 0;
 
-	if (++col->row_index < col->num_rows)
-		return;
+	while (root * root < value)
+		++root;
 
-	col->row_index = 0;
-	col->next(col);
+	return root;
 }
 
-static void
-grid_next(struct col *col)
+/* Stack num_rows tiles in a column of the given position and width, spanning
+ * the height of area. Returns the rectangle following the last one. */
+static struct swc_rectangle *
+column(struct swc_rectangle *rects, int32_t x, uint32_t width, const struct swc_rectangle *area,
+       unsigned num_rows, unsigned border_width)
 {
-	struct grid *grid = wl_container_of(col, grid, col);
-
-	++grid->col_index;
+	unsigned row;
 
-	if (grid->col_index == grid->num_windows % grid->num_cols) {
-		--col->num_rows;
-		col->tile.height = col->area->height / col->num_rows - 2 * border_width;
+	for (row = 0; row < num_rows; ++row, ++rects) {
+		rects->x = x + border_width;
+		rects->y = area->y + border_width + row * area->height / num_rows;
+		rects->width = width - 2 * border_width;
+		rects->height = area->height / num_rows - 2 * border_width;
 	}
 
-	col->tile.x = col->area->x + border_width + col->area->width * grid->col_index / grid->num_cols;
+	return rects;
 }
 
-static void
-grid(struct grid *grid, const struct swc_rectangle *area, unsigned num_windows, unsigned num_cols)
+/* Arrange num_windows tiles in num_cols columns. The first num_windows %
+ * num_cols columns get one more row than the others. */
+static struct swc_rectangle *
+grid(struct swc_rectangle *rects, const struct swc_rectangle *area, unsigned num_windows, unsigned num_cols,
+     unsigned border_width)
 {
+	unsigned col, num_rows, extra;
+
 	if (num_windows == 0)
-		return;
+		return rects;
 
-	grid->num_windows = num_windows;
-	grid->num_cols = num_cols;
-	grid->col.num_rows = num_windows / num_cols + (num_windows % num_cols > 0);
-	grid->col.row_index = 0;
-	grid->col_index = 0;
-	grid->col.tile.x = area->x + border_width;
-	grid->col.tile.width = area->width / num_cols - 2 * border_width;
-	grid->col.tile.height = area->height / grid->col.num_rows - 2 * border_width;
-	grid->col.area = area;
-	grid->col.next = &grid_next;
-}
+	num_rows = num_windows / num_cols;
+	extra = num_windows % num_cols;
 
-/* Tall layout */
-static void
-tall_next_col(struct col *col)
-{
-	struct tall_layout *layout = wl_container_of(col, layout, grid.col);
+	for (col = 0; col < num_cols; ++col)
+		rects = column(rects, area->x + area->width * col / num_cols, area->width / num_cols,
+		               area, num_rows + (col < extra), border_width);
 
-	grid(&layout->grid, &layout->grid_area, layout->grid.num_windows,
-	     MIN(layout->grid.num_windows, layout->num_columns));
+	return rects;
 }
 
-static void
-tall_begin(struct layout *base, const struct swc_rectangle *area, unsigned num_windows)
+/* Tall layout */
+static bool
+tall_arrange_all(struct layout *base, const struct swc_rectangle *area, unsigned border_width,
+                 struct window *const *windows, unsigned num_windows, struct swc_rectangle *rects)
 {
 	struct tall_layout *layout = (void *)base;
-	unsigned master_width;
+	struct swc_rectangle grid_area;
+	unsigned num_masters = MIN(num_windows, layout->num_masters), master_width;
 
-	layout->grid.col.num_rows = MIN(num_windows, layout->num_masters);
+	if (num_masters == 0)
+		return true;
 
-	if (layout->grid.col.num_rows == 0)
-		return;
+	if (num_windows == num_masters) {
+		column(rects, area->x, area->width, area, num_masters, border_width);
+		return true;
+	}
 
-	layout->grid.num_windows = num_windows - layout->grid.col.num_rows;
-
-	if (num_windows > layout->num_masters) {
-		master_width = area->width * layout->master_size / master_max;
-		layout->grid_area.x = area->x + master_width;
-		layout->grid_area.y = area->y;
-		layout->grid_area.height = area->height;
-		layout->grid_area.width = area->width - master_width;
-	} else
-		master_width = area->width;
-
-	layout->grid.col.tile = (struct swc_rectangle){
-		.x = area->x + border_width,
-		.width = master_width - 2 * border_width,
-		.height = area->height / layout->grid.col.num_rows - 2 * border_width,
+	master_width = area->width * layout->master_size / master_max;
+	grid_area = (struct swc_rectangle){
+		.x = area->x + master_width,
+		.y = area->y,
+		.width = area->width - master_width,
+		.height = area->height,
 	};
-	layout->grid.col.row_index = 0;
-	layout->grid.col.area = area;
-	layout->grid.col.next = &tall_next_col;
-}
 
-static void
-tall_arrange(struct layout *base, struct window *window)
-{
-	struct tall_layout *layout = (void *)base;
+	rects = column(rects, area->x, master_width, area, num_masters, border_width);
+	grid(rects, &grid_area, num_windows - num_masters,
+	     MIN(num_windows - num_masters, layout->num_columns), border_width);
 
-	tile(&layout->grid.col, window);
+	return true;
 }
 
 static const struct layout_impl tall_impl = {
-	.begin = &tall_begin,
-	.arrange = &tall_arrange,
+	.arrange_all = &tall_arrange_all,
 };
 
 static struct tall_layout *
@@ -191,53 +162,95 @@ error0:
 }
 
 /* Grid layout */
-static void
-grid_begin(struct layout *base, const struct swc_rectangle *area, unsigned num_windows)
+static bool
+grid_arrange_all(struct layout *layout, const struct swc_rectangle *area, unsigned border_width,
+                 struct window *const *windows, unsigned num_windows, struct swc_rectangle *rects)
 {
-	struct grid_layout *layout = (void *)base;
+	grid(rects, area, num_windows, ceil_sqrt(num_windows), border_width);
 
-	grid(&layout->grid, area, num_windows, ceil(sqrt(num_windows)));
+	return true;
 }
 
-static void
-grid_arrange(struct layout *base, struct window *window)
+static const struct layout_impl grid_impl = {
+	.arrange_all = &grid_arrange_all,
+};
+
+struct layout *
+grid_layout_new()
 {
-	struct grid_layout *layout = (void *)base;
+	struct layout *layout;
+
+	if (!(layout = malloc(sizeof *layout)))
+		goto error0;
+
+	layout->impl = &grid_impl;
 
-	tile(&layout->grid.col, window);
+	return layout;
+
+error0:
+	return NULL;
 }
 
-static const struct layout_impl grid_impl = {
-	.begin = &grid_begin,
-	.arrange = &grid_arrange,
+/* Monocle layout */
+static bool
+monocle_arrange_all(struct layout *layout, const struct swc_rectangle *area, unsigned border_width,
+                    struct window *const *windows, unsigned num_windows, struct swc_rectangle *rects)
+{
+	unsigned index;
+
+	/* Every window gets the whole area, so that focusing another one only
+	 * needs it to be shown. */
+	for (index = 0; index < num_windows; ++index) {
+		rects[index] = (struct swc_rectangle){
+			.x = area->x + border_width,
+			.y = area->y + border_width,
+			.width = area->width - 2 * border_width,
+			.height = area->height - 2 * border_width,
+		};
+	}
+
+	return true;
+}
+
+static const struct layout_impl monocle_impl = {
+	.arrange_all = &monocle_arrange_all,
+	.occludes = true,
 };
 
 struct layout *
-grid_layout_new()
+monocle_layout_new()
 {
-	struct grid_layout *layout;
+	struct layout *layout;
 
 	if (!(layout = malloc(sizeof *layout)))
 		goto error0;
 
-	layout->base.impl = &grid_impl;
+	layout->impl = &monocle_impl;
 
-	return &layout->base;
+	return layout;
 
 error0:
 	return NULL;
 }
 
+/* The tall layout of the active screen, if that is its current tiling layout.
+ * The actions below only rearrange that screen. */
+static struct tall_layout *
+active_tall_layout()
+{
+	return tall_layout(velox.active_screen->layout[TILE]);
+}
+
 static void
 increase_master_size(struct config_node *node, const struct variant *v)
 {
 	struct tall_layout *layout;
 
-	if (!(layout = tall_layout(velox.active_screen->layout[TILE])))
+	if (!(layout = active_tall_layout()))
 		return;
 
 	layout->master_size = MIN(layout->master_size + 1, master_max);
-	arrange();
+	schedule_update(velox.active_screen);
 }
 
 static void
@@ -245,11 +258,11 @@ decrease_master_size(struct config_node *node, const struct variant *v)
 {
 	struct tall_layout *layout;
 
-	if (!(layout = tall_layout(velox.active_screen->layout[TILE])))
+	if (!(layout = active_tall_layout()))
 		return;
 
 	layout->master_size = MAX(layout->master_size - 1, 0);
-	arrange();
+	schedule_update(velox.active_screen);
 }
 
 static void
@@ -257,11 +270,11 @@ increase_num_masters(struct config_node *node, const struct variant *v)
 {
 	struct tall_layout *layout;
 
-	if (!(layout = tall_layout(velox.active_screen->layout[TILE])))
+	if (!(layout = active_tall_layout()))
 		return;
 
 	++layout->num_masters;
-	arrange();
+	schedule_update(velox.active_screen);
 }
 
 static void
@@ -269,11 +282,11 @@ decrease_num_masters(struct config_node *node, const struct variant *v)
 {
 	struct tall_layout *layout;
 
-	if (!(layout = tall_layout(velox.active_screen->layout[TILE])))
+	if (!(layout = active_tall_layout()))
 		return;
 
 	layout->num_masters = MAX(layout->num_masters - 1, 1);
-	arrange();
+	schedule_update(velox.active_screen);
 }
 
 static void
@@ -281,11 +294,11 @@ increase_num_columns(struct config_node *node, const struct variant *v)
 {
 	struct tall_layout *layout;
 
-	if (!(layout = tall_layout(velox.active_screen->layout[TILE])))
+	if (!(layout = active_tall_layout()))
 		return;
 
 	++layout->num_columns;
-	arrange();
+	schedule_update(velox.active_screen);
 }
 
 static void
@@ -293,11 +306,11 @@ decrease_num_columns(struct config_node *node, const struct variant *v)
 {
 	struct tall_layout *layout;
 
-	if (!(layout = tall_layout(velox.active_screen->layout[TILE])))
+	if (!(layout = active_tall_layout()))
 		return;
 
 	layout->num_columns = MAX(layout->num_columns - 1, 1);
-	arrange();
+	schedule_update(velox.active_screen);
 }
 
 static struct {
@@ -320,20 +333,17 @@ static struct {
 };
 
 /* Stack layout */
-static void
-stack_begin(struct layout *layout, const struct swc_rectangle *area, unsigned num_windows)
-{
-}
-
-static void
-stack_arrange(struct layout *layout, struct window *window)
+static bool
+stack_arrange_all(struct layout *layout, const struct swc_rectangle *area, unsigned border_width,
+                  struct window *const *windows, unsigned num_windows, struct swc_rectangle *rects)
 {
-	/* TODO: Place window on top of stack when swc adds support for this. */
+	/* Stacked windows keep the geometry they were placed at, or the one the
+	 * user or client gave them. Their order is kept by the screen. */
+	return false;
 }
 
 static const struct layout_impl stack_impl = {
-	.begin = &stack_begin,
-	.arrange = &stack_arrange,
+	.arrange_all = &stack_arrange_all,
 };
 
 struct layout *
@@ -352,33 +362,29 @@ error0:
 	return NULL;
 }
 
-void
+bool
 layout_add_config_nodes()
 {
-	wl_list_init(&tall.config.group.group);
-	wl_list_insert(&tall.config.group.group,
-	               &tall.config.increase_master_size.link);
-	wl_list_insert(&tall.config.group.group,
-	               &tall.config.decrease_master_size.link);
-	wl_list_insert(&tall.config.group.group,
-	               &tall.config.increase_num_masters.link);
-	wl_list_insert(&tall.config.group.group,
-	               &tall.config.decrease_num_masters.link);
-	wl_list_insert(&tall.config.group.group,
-	               &tall.config.increase_num_columns.link);
-	wl_list_insert(&tall.config.group.group,
-	               &tall.config.decrease_num_columns.link);
-	wl_list_insert(config_root, &tall.config.group.link);
+	wl_list_init(&tall.config.group.group.nodes);
+
+	return config_add_node(&tall.config.group, &tall.config.increase_master_size)
+	    && config_add_node(&tall.config.group, &tall.config.decrease_master_size)
+	    && config_add_node(&tall.config.group, &tall.config.increase_num_masters)
+	    && config_add_node(&tall.config.group, &tall.config.decrease_num_masters)
+	    && config_add_node(&tall.config.group, &tall.config.increase_num_columns)
+	    && config_add_node(&tall.config.group, &tall.config.decrease_num_columns)
+	    && config_add_node(config_root, &tall.config.group);
 }
 
-void
-layout_begin(struct layout *layout, const struct swc_rectangle *area, unsigned num_windows)
+bool
+layout_arrange_all(struct layout *layout, const struct swc_rectangle *area, unsigned border_width,
+                   struct window *const *windows, unsigned num_windows, struct swc_rectangle *rects)
 {
-	layout->impl->begin(layout, area, num_windows);
+	return layout->impl->arrange_all(layout, area, border_width, windows, num_windows, rects);
 }
 
-void
-layout_arrange(struct layout *layout, struct window *window)
+bool
+layout_occludes(struct layout *layout)
 {
-	layout->impl->arrange(layout, window);
+	return layout->impl->occludes;
 }
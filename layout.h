@@ -24,6 +24,7 @@
 #ifndef VELOX_LAYOUT_H
 #define VELOX_LAYOUT_H
 
+#include <stdbool.h>
 #include <wayland-server.h>
 
 struct screen;
@@ -44,12 +45,27 @@ struct layout {
 
 struct layout *tall_layout_new();
 struct layout *grid_layout_new();
+struct layout *monocle_layout_new();
 
 struct layout *stack_layout_new();
 
-void layout_add_config_nodes();
+bool layout_add_config_nodes();
 
-void layout_begin(struct layout *layout, const struct swc_rectangle *area, unsigned num_windows);
-void layout_arrange(struct layout *layout, struct window *window);
+/**
+ * Compute the geometry of the num_windows windows given, in order, tiled in
+ * area, and store it in rects, which must have room for num_windows
+ * rectangles.
+ *
+ * Returns false if the layout leaves the geometry of its windows alone, in
+ * which case rects is left untouched.
+ */
+bool layout_arrange_all(struct layout *layout, const struct swc_rectangle *area, unsigned border_width,
+                        struct window *const *windows, unsigned num_windows, struct swc_rectangle *rects);
+
+/**
+ * Whether each window the layout arranges covers all of the others, in which
+ * case only the focused one is shown.
+ */
+bool layout_occludes(struct layout *layout);
 
 #endif
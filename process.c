@@ -0,0 +1,159 @@
+/* velox: process.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "process.h"
+#include "util.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+extern char **environ;
+
+static const char whitespace[] = " \t";
+
+/* Characters that only have a meaning to the shell. */
+static const char shell_characters[] = "\"'\\$`|&;<>()[]{}*?~#=!\n";
+
+/* The file actions and attributes are set up once, so that spawning a program
+ * doesn't need to open /dev/null again. */
+static struct {
+	bool initialized;
+	posix_spawn_file_actions_t quiet;
+	posix_spawnattr_t attr;
+} state;
+
+static bool
+initialize()
+{
+	sigset_t mask;
+	int null;
+
+	if ((null = open("/dev/null", O_RDWR | O_CLOEXEC)) == -1)
+		goto error0;
+	if (posix_spawn_file_actions_init(&state.quiet) != 0)
+		goto error1;
+	if (posix_spawn_file_actions_adddup2(&state.quiet, null, STDIN_FILENO) != 0
+	    || posix_spawn_file_actions_adddup2(&state.quiet, null, STDOUT_FILENO) != 0
+	    || posix_spawn_file_actions_adddup2(&state.quiet, null, STDERR_FILENO) != 0) {
+		goto error2;
+	}
+	if (posix_spawnattr_init(&state.attr) != 0)
+		goto error2;
+
+	/* The signals handled by the event loop are blocked in the compositor, so
+	 * make sure they aren't blocked in the new program as well. */
+	sigemptyset(&mask);
+	if (posix_spawnattr_setsigmask(&state.attr, &mask) != 0
+	    || posix_spawnattr_setflags(&state.attr, POSIX_SPAWN_SETSIGMASK) != 0) {
+		goto error3;
+	}
+
+	/* The /dev/null descriptor is kept open for future spawns. */
+	state.initialized = true;
+
+	return true;
+
+error3:
+	posix_spawnattr_destroy(&state.attr);
+error2:
+	posix_spawn_file_actions_destroy(&state.quiet);
+error1:
+	close(null);
+error0:
+	return false;
+}
+
+char **
+process_argv(struct arena *arena, const char *command)
+{
+	char **argv, *copy, *word, *rest;
+	size_t argc = 0;
+	const char *s;
+
+	if (strpbrk(command, shell_characters)) {
+		if (!(argv = arena_alloc(arena, 4 * sizeof *argv)))
+			return NULL;
+		argv[0] = "/bin/sh";
+		argv[1] = "-c";
+		if (!(argv[2] = arena_strdup(arena, command)))
+			return NULL;
+		argv[3] = NULL;
+		return argv;
+	}
+
+	/* Count the words to size the argument vector. */
+	for (s = command + strspn(command, whitespace); *s; s += strspn(s, whitespace)) {
+		s += strcspn(s, whitespace);
+		++argc;
+	}
+
+	if (argc == 0)
+		return NULL;
+
+	if (!(argv = arena_alloc(arena, (argc + 1) * sizeof *argv)))
+		return NULL;
+	if (!(copy = arena_strdup(arena, command)))
+		return NULL;
+
+	argc = 0;
+	for (word = strtok_r(copy, whitespace, &rest); word; word = strtok_r(NULL, whitespace, &rest))
+		argv[argc++] = word;
+	argv[argc] = NULL;
+
+	return argv;
+}
+
+bool
+process_spawn(char *const argv[], bool quiet)
+{
+	pid_t pid;
+	int error;
+#ifdef ENABLE_DEBUG
+	struct timespec start;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+#endif
+
+	if (!state.initialized && !initialize()) {
+		fprintf(stderr, "Failed to set up process spawning\n");
+		return false;
+	}
+
+	error = posix_spawnp(&pid, argv[0], quiet ? &state.quiet : NULL, &state.attr, argv, environ);
+
+	if (error != 0) {
+		fprintf(stderr, "Failed to spawn '%s': %s\n", argv[0], strerror(error));
+		return false;
+	}
+
+#ifdef ENABLE_DEBUG
+	fprintf(stderr, "Spawned '%s' in %.3f ms\n", argv[0], elapsed_ms(&start));
+#endif
+
+	return true;
+}
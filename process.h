@@ -0,0 +1,49 @@
+/* velox: process.h
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VELOX_PROCESS_H
+#define VELOX_PROCESS_H
+
+#include <stdbool.h>
+
+struct arena;
+
+/**
+ * Build the argument vector used to run a command, allocated from the given
+ * arena.
+ *
+ * Commands made up of plain words are split on whitespace and run directly,
+ * while anything containing shell syntax is run with /bin/sh -c.
+ */
+char **process_argv(struct arena *arena, const char *command);
+
+/**
+ * Start a program without waiting for it. argv[0] is searched for in PATH
+ * unless it contains a slash.
+ *
+ * If quiet is true, the program's standard input and output streams are
+ * redirected to /dev/null.
+ */
+bool process_spawn(char *const argv[], bool quiet);
+
+#endif
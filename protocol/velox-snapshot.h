@@ -0,0 +1,97 @@
+/* velox: protocol/velox-snapshot.h
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VELOX_SNAPSHOT_PROTOCOL_H
+#define VELOX_SNAPSHOT_PROTOCOL_H
+
+/* The layout of the memory shared by velox_snapshot objects.
+ *
+ * The compositor increments sequence before and after it changes the
+ * snapshot, so it is odd while the snapshot is being written. Readers should
+ * use velox_snapshot_read to get a consistent copy. */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define VELOX_SNAPSHOT_VERSION 1
+
+#define VELOX_SNAPSHOT_MAX_SCREENS 16
+#define VELOX_SNAPSHOT_MAX_TAGS 64
+#define VELOX_SNAPSHOT_MASK_WORDS ((VELOX_SNAPSHOT_MAX_TAGS + 63) / 64)
+#define VELOX_SNAPSHOT_NAME_SIZE 32
+#define VELOX_SNAPSHOT_TITLE_SIZE 256
+
+struct velox_snapshot_screen {
+	int32_t x, y;
+	uint32_t width, height;
+	/* The tags shown on the screen, with bit i of word i / 64 set for tag i. */
+	uint64_t mask[VELOX_SNAPSHOT_MASK_WORDS];
+	/* The tag of the focused window, or -1 if there is none. */
+	int32_t focus_tag;
+	uint32_t num_windows;
+	/* The focused window's title, truncated and NUL-terminated. It is empty if
+	 * there is no focused window or it has no title. */
+	char title[VELOX_SNAPSHOT_TITLE_SIZE];
+};
+
+struct velox_snapshot_tag {
+	char name[VELOX_SNAPSHOT_NAME_SIZE];
+	uint32_t num_windows;
+	/* The index of the screen showing the tag, or -1 if it is not shown. */
+	int32_t screen;
+};
+
+struct velox_snapshot {
+	uint32_t version;
+	uint32_t sequence;
+	uint32_t num_screens, num_tags;
+	/* The index of the active screen, or -1 if there are no screens. */
+	int32_t active_screen;
+	uint32_t padding;
+	struct velox_snapshot_screen screens[VELOX_SNAPSHOT_MAX_SCREENS];
+	struct velox_snapshot_tag tags[VELOX_SNAPSHOT_MAX_TAGS];
+};
+
+/**
+ * Copy a snapshot out of shared memory, retrying while the compositor is in
+ * the middle of changing it.
+ *
+ * Returns false if the snapshot has a version this header doesn't know.
+ */
+static inline bool
+velox_snapshot_read(const struct velox_snapshot *shared, struct velox_snapshot *snapshot)
+{
+	uint32_t sequence;
+
+	do {
+		while ((sequence = __atomic_load_n(&shared->sequence, __ATOMIC_ACQUIRE)) & 1)
+			;
+		memcpy(snapshot, (const void *)shared, sizeof *snapshot);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while (__atomic_load_n(&shared->sequence, __ATOMIC_RELAXED) != sequence);
+
+	return snapshot->version == VELOX_SNAPSHOT_VERSION;
+}
+
+#endif
@@ -0,0 +1,184 @@
+/* velox: rule.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "rule.h"
+#include "config.h"
+#include "window.h"
+
+#include <fnmatch.h>
+#include <stdio.h>
+#include <string.h>
+#include <swc.h>
+
+struct rules *
+rules_new(struct arena *arena)
+{
+	struct rules *rules;
+	unsigned type;
+
+	if (!(rules = arena_alloc(arena, sizeof *rules)))
+		goto error0;
+
+	for (type = 0; type < NUM_RULE_TYPES; ++type) {
+		if (!hash_table_init(&rules->exact[type]))
+			goto error1;
+		wl_list_init(&rules->patterns[type]);
+	}
+
+	return rules;
+
+error1:
+	while (type > 0)
+		hash_table_finish(&rules->exact[--type]);
+error0:
+	return NULL;
+}
+
+void
+rules_destroy(struct rules *rules)
+{
+	struct hash_entry *entry, *next;
+	struct rule *rule, *tmp;
+	unsigned type, index;
+
+	for (type = 0; type < NUM_RULE_TYPES; ++type) {
+		for (index = 0; index < rules->exact[type].size; ++index) {
+			for (entry = rules->exact[type].buckets[index]; entry; entry = next) {
+				next = entry->next;
+				rule_destroy(wl_container_of(entry, rule, entry));
+			}
+		}
+		hash_table_finish(&rules->exact[type]);
+
+		wl_list_for_each_safe (rule, tmp, &rules->patterns[type], link)
+			rule_destroy(rule);
+	}
+}
+
+struct rule *
+rule_new(struct arena *arena, enum rule_type type, enum rule_match match,
+         const char *identifier, struct config_node *action)
+{
+	struct rule *rule;
+	char message[256];
+	int error;
+
+	if (!(rule = arena_alloc(arena, sizeof *rule)))
+		return NULL;
+
+	rule->type = type;
+	rule->match = match;
+	rule->action = action;
+
+	if (!(rule->identifier = arena_strdup(arena, identifier)))
+		return NULL;
+
+	if (match == RULE_MATCH_REGEX) {
+		if ((error = regcomp(&rule->regex, identifier, REG_EXTENDED | REG_NOSUB)) != 0) {
+			regerror(error, &rule->regex, message, sizeof message);
+			fprintf(stderr, "Invalid regular expression '%s': %s\n", identifier, message);
+			return NULL;
+		}
+	}
+
+	return rule;
+}
+
+void
+rule_destroy(struct rule *rule)
+{
+	if (rule->match == RULE_MATCH_REGEX)
+		regfree(&rule->regex);
+}
+
+bool
+rules_add(struct rules *rules, struct rule *rule)
+{
+	if (rule->match == RULE_MATCH_EXACT) {
+		rule->entry.key = rule->identifier;
+		return hash_table_insert(&rules->exact[rule->type], &rule->entry);
+	}
+
+	wl_list_insert(rules->patterns[rule->type].prev, &rule->link);
+
+	return true;
+}
+
+static void
+run(struct rule *rule, struct window *window)
+{
+	struct config_node *node = rule->action;
+	const struct variant v = {
+		.type = VARIANT_WINDOW,
+		.window = window
+	};
+
+	node->action.run(node, &v);
+}
+
+static bool
+match(struct rule *rule, const char *identifier)
+{
+	switch (rule->match) {
+	case RULE_MATCH_GLOB:
+		return fnmatch(rule->identifier, identifier, 0) == 0;
+	case RULE_MATCH_REGEX:
+		return regexec(&rule->regex, identifier, 0, NULL, 0) == 0;
+	default:
+		return strcmp(rule->identifier, identifier) == 0;
+	}
+}
+
+void
+rules_apply(struct rules *rules, enum rule_type type, struct window *window)
+{
+	struct hash_entry *entry;
+	struct rule *rule;
+	const char *identifier;
+
+	switch (type) {
+	case RULE_TYPE_WINDOW_TITLE:
+		identifier = window->swc->title;
+		break;
+	case RULE_TYPE_APP_ID:
+		identifier = window->swc->app_id;
+		break;
+	default:
+		identifier = NULL;
+		break;
+	}
+
+	if (!rules || !identifier)
+		return;
+
+	entry = hash_table_lookup(&rules->exact[type], identifier, strlen(identifier));
+	for (; entry; entry = hash_table_lookup_next(entry)) {
+		rule = wl_container_of(entry, rule, entry);
+		run(rule, window);
+	}
+
+	wl_list_for_each (rule, &rules->patterns[type], link) {
+		if (match(rule, identifier))
+			run(rule, window);
+	}
+}
@@ -0,0 +1,94 @@
+/* velox: rule.h
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VELOX_RULE_H
+#define VELOX_RULE_H
+
+#include "util.h"
+
+#include <regex.h>
+#include <stdbool.h>
+#include <wayland-util.h>
+
+struct config_node;
+struct window;
+
+enum rule_type {
+	RULE_TYPE_WINDOW_TITLE,
+	RULE_TYPE_APP_ID,
+
+	NUM_RULE_TYPES
+};
+
+enum rule_match {
+	RULE_MATCH_EXACT,
+	RULE_MATCH_GLOB,
+	RULE_MATCH_REGEX,
+};
+
+struct rule {
+	enum rule_type type;
+	enum rule_match match;
+	char *identifier;
+	regex_t regex;
+	struct config_node *action;
+
+	/* Exact rules are kept in a hash table, and pattern rules in a list. */
+	union {
+		struct hash_entry entry;
+		struct wl_list link;
+	};
+};
+
+struct rules {
+	struct hash_table exact[NUM_RULE_TYPES];
+	struct wl_list patterns[NUM_RULE_TYPES];
+};
+
+/**
+ * Rules and rule sets are allocated from an arena, so destroying them only
+ * releases the resources they hold outside of it.
+ */
+struct rules *rules_new(struct arena *arena);
+void rules_destroy(struct rules *rules);
+
+struct rule *rule_new(struct arena *arena, enum rule_type type, enum rule_match match,
+                      const char *identifier, struct config_node *action);
+void rule_destroy(struct rule *rule);
+
+/**
+ * Add a rule to a rule set.
+ *
+ * Rules that match a window are run in the order they were added, with all
+ * the exact rules running before the pattern rules.
+ */
+bool rules_add(struct rules *rules, struct rule *rule);
+
+/**
+ * Run the actions of all the rules of the given type that match a window.
+ *
+ * rules may be NULL, in which case nothing is done.
+ */
+void rules_apply(struct rules *rules, enum rule_type type, struct window *window);
+
+#endif
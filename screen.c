@@ -22,7 +22,10 @@
  */
 
 #include "screen.h"
+#include "config.h"
 #include "layout.h"
+#include "stats.h"
+#include "trace.h"
 #include "util.h"
 #include "velox.h"
 #include "window.h"
@@ -33,9 +36,62 @@
 #include <string.h>
 #include <swc.h>
 
+static struct pool screens = POOL_INITIALIZER(struct screen);
+static unsigned title_rate_hz = 10;
+
+static bool
+title_rate_hz_set(struct config_node *node, const char *value)
+{
+	return config_set_unsigned(&title_rate_hz, value, 0);
+}
+
+/* Set the border width of the active screen only. window.border_width sets it
+ * for every screen. */
+static bool
+border_width_set(struct config_node *node, const char *value)
+{
+	struct screen *screen = velox.active_screen;
+	unsigned width;
+
+	if (!screen || !config_set_unsigned(&width, value, 0))
+		return false;
+
+	if (screen->border_width != width) {
+		screen->border_width = width;
+		schedule_update(screen);
+	}
+
+	return true;
+}
+
+static void
+title_rate_hz_get(struct config_node *node, char *value, size_t size)
+{
+	config_get_unsigned(value, size, title_rate_hz, 10);
+}
+
+static void
+border_width_get(struct config_node *node, char *value, size_t size)
+{
+	config_get_unsigned(value, size, velox.active_screen ? velox.active_screen->border_width : border_width, 10);
+}
+
+static CONFIG_GROUP(screen);
+static CONFIG_PROPERTY(title_rate_hz, &title_rate_hz_set, &title_rate_hz_get);
+static CONFIG_PROPERTY(border_width, &border_width_set, &border_width_get);
+
+bool
+screen_add_config_nodes()
+{
+	return config_add_node(&screen_group, &title_rate_hz_property)
+	    && config_add_node(&screen_group, &border_width_property)
+	    && config_add_node(config_root, &screen_group);
+}
+
 static struct layout *(*default_layouts[])() = {
 	&tall_layout_new,
 	&grid_layout_new,
+	&monocle_layout_new,
 };
 
 static void
@@ -43,7 +99,10 @@ usable_geometry_changed(void *data)
 {
 	struct screen *screen = data;
 
-	screen_arrange(screen);
+	trace_begin("usable_geometry_changed");
+	screen_update_neighbors();
+	schedule_update(screen);
+	trace_end("usable_geometry_changed");
 }
 
 static void
@@ -51,8 +110,12 @@ entered(void *data)
 {
 	struct screen *screen = data;
 
+	trace_begin("screen_entered");
 	velox.active_screen = screen;
 	window_focus(screen->focus);
+	/* Let the next update publish the new active screen. */
+	schedule_update(NULL);
+	trace_end("screen_entered");
 }
 
 static const struct swc_screen_handler screen_handler = {
@@ -60,26 +123,6 @@ static const struct swc_screen_handler screen_handler = {
 	.entered = &entered,
 };
 
-static void
-add_window(struct screen *screen, struct window *window)
-{
-	/* Remove the window from hidden window list and add it to the screen's list
-	 * of windows. */
-	wl_list_remove(&window->link);
-	wl_list_insert(screen->windows.prev, &window->link);
-	++screen->num_windows[window->layer];
-}
-
-static void
-remove_window(struct screen *screen, struct window *window)
-{
-	/* Remove the window from the screen's list of windows, and add it to the list
-	 * of hidden windows. */
-	wl_list_remove(&window->link);
-	wl_list_insert(velox.hidden_windows.prev, &window->link);
-	--screen->num_windows[window->layer];
-}
-
 static void
 send_focus(struct screen *screen, struct wl_resource *resource)
 {
@@ -95,6 +138,29 @@ send_focus(struct screen *screen, struct wl_resource *resource)
 	}
 
 	velox_screen_send_focus(resource, title, tag);
+	stats_count(STATS_EVENTS);
+}
+
+static int
+title_timer_expired(void *data)
+{
+	struct screen *screen = data;
+
+	screen->title_pending = false;
+	screen->last_title_time = now_ms();
+	stats_count(STATS_TITLES_DELIVERED);
+	screen_focus_notify(screen);
+
+	return 0;
+}
+
+static void
+send_done(struct wl_resource *resource)
+{
+	if (wl_resource_get_version(resource) >= VELOX_SCREEN_DONE_SINCE_VERSION) {
+		velox_screen_send_done(resource);
+		stats_count(STATS_EVENTS);
+	}
 }
 
 struct screen *
@@ -105,7 +171,7 @@ screen_new(struct swc_screen *swc)
 	struct layout *layout, *tmp;
 	unsigned index;
 
-	if (!(screen = malloc(sizeof *screen)))
+	if (!(screen = pool_alloc(&screens)))
 		goto error0;
 
 	wl_list_init(&screen->layouts);
@@ -118,18 +184,32 @@ screen_new(struct swc_screen *swc)
 	if (!(screen->layout[STACK] = stack_layout_new()))
 		goto error1;
 
-	wl_list_init(&screen->tags);
-	screen->mask = 0;
-	if ((tag = find_unused_tag()))
-		tag_set(tag, screen);
-	screen->last_mask = screen->mask;
-
 	wl_list_init(&screen->windows);
 	memset(screen->num_windows, 0, sizeof screen->num_windows);
 	screen->focus = NULL;
+	wl_list_init(&screen->stack);
+	screen->restack = false;
+	screen->border_width = border_width;
+	screen->dirty = false;
+	spatial_index_initialize(&screen->index);
+	memset(screen->neighbors, 0, sizeof screen->neighbors);
+
+	wl_list_init(&screen->tags);
+	memset(&screen->mask, 0, sizeof screen->mask);
+	if ((tag = find_unused_tag())) {
+		tag_set(tag, screen);
+		screen_add_windows(screen, tag);
+	}
+	screen->last_mask = screen->mask;
 
 	screen->swc = swc;
 	wl_list_init(&screen->resources);
+	screen->focus_changed = false;
+	screen->sent_title = NULL;
+	screen->sent_tag = NULL;
+	screen->title_timer = NULL;
+	screen->title_pending = false;
+	screen->last_title_time = 0;
 	swc_screen_set_handler(swc, &screen_handler, screen);
 
 	return screen;
@@ -137,6 +217,7 @@ screen_new(struct swc_screen *swc)
 error1:
 	wl_list_for_each_safe (layout, tmp, &screen->layouts, link)
 		free(layout);
+	pool_free(&screens, screen);
 error0:
 	return NULL;
 }
@@ -144,76 +225,242 @@ error0:
 void
 screen_arrange(struct screen *screen)
 {
-	struct window *window;
+	unsigned num_windows = screen->num_windows[TILE] + screen->num_windows[STACK];
+	struct window *window, *shown, *windows[num_windows + 1];
+	struct swc_rectangle rects[num_windows + 1];
+	unsigned start[NUM_LAYERS], count[NUM_LAYERS] = { 0 }, layer, index;
+	bool arranged, occludes;
+
+	trace_begin("arrange");
 
-	layout_begin(screen->layout[TILE], &screen->swc->usable_geometry, screen->num_windows[TILE]);
-	layout_begin(screen->layout[STACK], &screen->swc->usable_geometry, screen->num_windows[STACK]);
+	/* Gather the windows of each layer, in order, into consecutive ranges. */
+	for (layer = 0, index = 0; layer < NUM_LAYERS; index += screen->num_windows[layer++])
+		start[layer] = index;
 	wl_list_for_each (window, &screen->windows, link)
-		layout_arrange(screen->layout[window->layer], window);
+		windows[start[window->layer] + count[window->layer]++] = window;
+
+	for (layer = 0; layer < NUM_LAYERS; ++layer) {
+		arranged = layout_arrange_all(screen->layout[layer], &screen->swc->usable_geometry, screen->border_width,
+		                              &windows[start[layer]], count[layer], &rects[start[layer]]);
+		if (layer == TILE)
+			spatial_index_update(&screen->index, &windows[start[layer]], &rects[start[layer]],
+			                     arranged ? count[layer] : 0);
+		if (!arranged)
+			continue;
+		for (index = start[layer]; index < start[layer] + count[layer]; ++index)
+			window_set_geometry(windows[index], &rects[index]);
+	}
+
+	/* If the tiles cover each other, only the focused one needs to be shown.
+	 * While a stacked window has focus, the tile that was on top stays there,
+	 * or the first one if there is none. */
+	occludes = layout_occludes(screen->layout[TILE]);
+	shown = count[TILE] > 0 ? windows[start[TILE]] : NULL;
+	if (screen->focus && screen->focus->layer == TILE) {
+		shown = screen->focus;
+	} else {
+		for (index = start[TILE]; index < start[TILE] + count[TILE]; ++index) {
+			if (!windows[index]->occluded) {
+				shown = windows[index];
+				break;
+			}
+		}
+	}
+	for (index = 0; index < num_windows; ++index) {
+		window = windows[index];
+		window_set_occluded(window, occludes && window->layer == TILE && window != shown);
+	}
+
+	trace_end("arrange");
+}
+
+/* Gather the tiled windows that would be visible after switching to the
+ * previous tags, in the order screen_set_tags would leave them, into windows
+ * unless it is NULL. Returns the number of windows. */
+static unsigned
+previous_windows(struct screen *screen, struct window **windows)
+{
+	struct tag_mask added;
+	struct window *window;
+	struct tag *tag;
+	unsigned num_windows = 0, word;
+
+	/* Windows of tags that stay keep their place. */
+	wl_list_for_each (window, &screen->windows, link) {
+		if (window->layer != TILE || !tag_mask_has(&screen->last_mask, window->tag))
+			continue;
+		if (windows)
+			windows[num_windows] = window;
+		++num_windows;
+	}
+
+	/* Windows of added tags are appended. */
+	for (word = 0; word < TAG_MASK_WORDS; ++word)
+		added.words[word] = screen->last_mask.words[word] & ~screen->mask.words[word];
+	while ((tag = next_tag(&added))) {
+		wl_list_for_each (window, &tag->windows, tag_link) {
+			if (window->layer != TILE)
+				continue;
+			if (windows)
+				windows[num_windows] = window;
+			++num_windows;
+		}
+	}
+
+	return num_windows;
 }
 
 void
-screen_add_windows(struct screen *screen)
+screen_preconfigure(struct screen *screen)
 {
-	struct window *window, *tmp;
+	unsigned num_windows = tag_mask_equal(&screen->last_mask, &screen->mask) ? 0 : previous_windows(screen, NULL);
+	struct window *windows[num_windows + 1];
+	struct swc_rectangle rects[num_windows + 1];
+	unsigned index;
 
-	wl_list_for_each_safe (window, tmp, &velox.hidden_windows, link) {
-		if (screen->mask & window->tag->mask) {
-			add_window(screen, window);
+	if (num_windows == 0)
+		return;
+
+	previous_windows(screen, windows);
+	if (!layout_arrange_all(screen->layout[TILE], &screen->swc->usable_geometry, screen->border_width,
+	                        windows, num_windows, rects))
+		return;
 
-			if (!screen->focus)
-				screen_set_focus(screen, window);
+	/* Windows that are visible, here or on another screen, have to keep their
+	 * current geometry. */
+	for (index = 0; index < num_windows; ++index) {
+		if (!windows[index]->tag->screen)
+			window_set_geometry(windows[index], &rects[index]);
+	}
+}
+
+void
+screen_update_neighbors()
+{
+	struct screen *screen, *other, *best;
+	unsigned direction;
+
+	wl_list_for_each (screen, &velox.screens, link) {
+		for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+			best = NULL;
+			wl_list_for_each (other, &velox.screens, link) {
+				if (other != screen && spatial_is_better(&screen->swc->usable_geometry, &other->swc->usable_geometry,
+				                                         best ? &best->swc->usable_geometry : NULL, direction))
+					best = other;
+			}
+			screen->neighbors[direction] = best;
 		}
 	}
 }
 
 void
-screen_remove_windows(struct screen *screen)
+screen_focus_direction(struct screen *screen, enum direction direction)
 {
-	struct window *window, *tmp;
+	struct window *window;
 
-	/* If we will be removing the focus, try to find a new focus nearby the old
-	 * one. */
-	if (screen->focus && !(screen->focus->tag && screen->mask & screen->focus->tag->mask)) {
-		struct wl_list *forward = screen->focus->link.next, *backward = screen->focus->link.prev;
+	/* Bring the index up to date, so that it doesn't refer to windows that
+	 * have since been removed. */
+	if (screen->dirty)
+		update();
+
+	if (!screen->focus || screen->focus->layer != TILE)
+		return;
 
-		while (true) {
-			if (forward != &screen->windows) {
-				window = wl_container_of(forward, window, link);
+	if ((window = spatial_index_find(&screen->index, window_target_geometry(screen->focus), direction)))
+		screen_set_focus(screen, window);
+}
 
-				if (screen->mask & window->tag->mask) {
-					screen_set_focus(screen, window);
-					break;
-				}
+void
+screen_activate_direction(struct screen *screen, enum direction direction)
+{
+	if (!(screen = screen->neighbors[direction]))
+		return;
 
-				forward = forward->next;
-			}
+	velox.active_screen = screen;
+	window_focus(screen->focus);
+	schedule_update(NULL);
+}
 
-			if (backward != &screen->windows) {
-				window = wl_container_of(backward, window, link);
+/* Find the closest window to the focus that is still visible on the screen. */
+static struct window *
+nearby_window(struct screen *screen)
+{
+	struct wl_list *forward = screen->focus->link.next, *backward = screen->focus->link.prev;
+	struct window *window;
 
-				if (screen->mask & window->tag->mask) {
-					screen_set_focus(screen, window);
-					break;
-				}
+	while (forward != &screen->windows || backward != &screen->windows) {
+		if (forward != &screen->windows) {
+			window = wl_container_of(forward, window, link);
 
-				backward = backward->next;
-			}
+			if (window->tag->screen == screen)
+				return window;
 
-			/* If there is no suitable candidate for focus, we can just remove all the
-			 * windows and set the focus to NULL. */
-			screen_set_focus(screen, NULL);
-			wl_list_insert_list(&velox.hidden_windows, &screen->windows);
-			wl_list_init(&screen->windows);
-			memset(screen->num_windows, 0, sizeof screen->num_windows);
-			return;
+			forward = forward->next;
 		}
-	}
 
-	wl_list_for_each_safe (window, tmp, &screen->windows, link) {
-		if (!(window->tag && screen->mask & window->tag->mask))
-			remove_window(screen, window);
+		if (backward != &screen->windows) {
+			window = wl_container_of(backward, window, link);
+
+			if (window->tag->screen == screen)
+				return window;
+
+			backward = backward->prev;
+		}
 	}
+
+	return NULL;
+}
+
+void
+screen_add_window(struct screen *screen, struct window *window)
+{
+	wl_list_insert(screen->windows.prev, &window->link);
+	if (window->layer == STACK)
+		wl_list_insert(screen->stack.prev, &window->stack_link);
+	++screen->num_windows[window->layer];
+	window_set_visible(window, true);
+	schedule_update(screen);
+
+	if (!screen->focus)
+		screen_set_focus(screen, window);
+}
+
+void
+screen_remove_window(struct screen *screen, struct window *window)
+{
+	if (screen->focus == window)
+		screen_set_focus(screen, nearby_window(screen));
+
+	wl_list_remove(&window->link);
+	wl_list_init(&window->link);
+	wl_list_remove(&window->stack_link);
+	wl_list_init(&window->stack_link);
+	--screen->num_windows[window->layer];
+	window_set_visible(window, false);
+	schedule_update(screen);
+}
+
+void
+screen_add_windows(struct screen *screen, struct tag *tag)
+{
+	struct window *window;
+
+	wl_list_for_each (window, &tag->windows, tag_link)
+		screen_add_window(screen, window);
+}
+
+void
+screen_remove_windows(struct screen *screen, struct tag *tag)
+{
+	struct window *window;
+
+	/* If we will be removing the focus, try to find a new focus nearby the old
+	 * one before any windows are removed. */
+	if (screen->focus && screen->focus->tag == tag)
+		screen_set_focus(screen, nearby_window(screen));
+
+	wl_list_for_each (window, &tag->windows, tag_link)
+		screen_remove_window(screen, window);
 }
 
 void
@@ -254,26 +501,95 @@ screen_set_focus(struct screen *screen, struct window *window)
 	if (window)
 		assert(window->tag->screen == screen);
 
+	/* The newly focused window may be covered by the previous one. */
+	if (window != screen->focus && layout_occludes(screen->layout[TILE]))
+		schedule_update(screen);
+
 	screen->focus = window;
 	screen_focus_notify(screen);
 
+	if (window && window->layer == STACK)
+		screen_raise(screen, window);
+
 	if (screen == velox.active_screen)
 		window_focus(screen->focus);
 }
 
+/* swc puts a window above all the others each time it is shown, which is the
+ * only way to change the order it draws them in. */
+static void
+restack_window(struct window *window)
+{
+	swc_window_hide(window->swc);
+	swc_window_show(window->swc);
+	stats_count(STATS_RESTACKS);
+}
+
+void
+screen_raise(struct screen *screen, struct window *window)
+{
+	if (window->layer != STACK || window->stack_link.next == &screen->stack)
+		return;
+
+	wl_list_remove(&window->stack_link);
+	wl_list_insert(screen->stack.prev, &window->stack_link);
+
+	/* Only the raised window needs to be shown again, unless the next update
+	 * restacks all of them anyway. */
+	if (window->shown && !screen->restack)
+		restack_window(window);
+}
+
+void
+screen_lower(struct screen *screen, struct window *window)
+{
+	if (window->layer != STACK || screen->stack.next == &window->stack_link)
+		return;
+
+	wl_list_remove(&window->stack_link);
+	wl_list_insert(&screen->stack, &window->stack_link);
+
+	/* The order changed, but nothing needs to be arranged. */
+	screen->restack = true;
+	schedule_update(NULL);
+}
+
 void
-screen_set_tags(struct screen *screen, uint32_t mask)
+screen_restack(struct screen *screen)
+{
+	struct window *window;
+
+	wl_list_for_each (window, &screen->stack, stack_link) {
+		if (window->shown)
+			restack_window(window);
+	}
+
+	screen->restack = false;
+}
+
+void
+screen_set_tags(struct screen *screen, const struct tag_mask *mask)
 {
 	struct screen *original_screen;
 	struct tag *tag, *unused_tag;
-	uint32_t added = (screen->mask | mask) & ~screen->mask, removed = (screen->mask | mask) & ~mask;
+	struct tag_mask added, removed;
+	unsigned word;
+	uint64_t start;
 
-	if (screen->mask == mask)
+	if (tag_mask_equal(&screen->mask, mask))
 		return;
 
-	while ((tag = next_tag(&removed)))
+	start = stats_now();
+
+	for (word = 0; word < TAG_MASK_WORDS; ++word) {
+		added.words[word] = mask->words[word] & ~screen->mask.words[word];
+		removed.words[word] = screen->mask.words[word] & ~mask->words[word];
+	}
+
+	while ((tag = next_tag(&removed))) {
 		tag_set(tag, NULL);
-	screen_remove_windows(screen);
+		screen_remove_windows(screen, tag);
+	}
 
 	/* Now, remove all the tags we want to add to this screen from their current
 	 * screens. */
@@ -283,26 +599,31 @@ screen_set_tags(struct screen *screen, uint32_t mask)
 		tag_remove(tag, original_screen);
 
 		if (original_screen) {
+			screen_remove_windows(original_screen, tag);
+
 			/* Make sure screens always have a tag visible, if possible. */
-			if (!original_screen->mask && (unused_tag = find_unused_tag()))
+			if (tag_mask_is_empty(&original_screen->mask) && (unused_tag = find_unused_tag())) {
 				tag_set(unused_tag, original_screen);
-			screen_remove_windows(original_screen);
-			screen_add_windows(original_screen);
+				screen_add_windows(original_screen, unused_tag);
+			}
 		}
 	}
 
-	while ((tag = next_tag(&added)))
+	while ((tag = next_tag(&added))) {
 		tag_add(tag, screen);
-	screen_add_windows(screen);
+		screen_add_windows(screen, tag);
+	}
+
+	stats_record(STATS_SET_TAGS, start);
 }
 
 struct wl_resource *
-screen_bind(struct screen *screen, struct wl_client *client, uint32_t id)
+screen_bind(struct screen *screen, struct wl_client *client, uint32_t version, uint32_t id)
 {
 	struct wl_resource *resource;
 	struct tag *tag;
 
-	resource = wl_resource_create(client, &velox_screen_interface, 1, id);
+	resource = wl_resource_create(client, &velox_screen_interface, version, id);
 
 	if (!resource)
 		return NULL;
@@ -310,6 +631,7 @@ screen_bind(struct screen *screen, struct wl_client *client, uint32_t id)
 	wl_list_insert(&screen->resources, wl_resource_get_link(resource));
 	wl_resource_set_destructor(resource, &remove_resource);
 	send_focus(screen, resource);
+	send_done(resource);
 
 	wl_list_for_each (tag, &screen->tags, link)
 		tag_send_screen(tag, client, NULL, resource);
@@ -319,9 +641,81 @@ screen_bind(struct screen *screen, struct wl_client *client, uint32_t id)
 
 void
 screen_focus_notify(struct screen *screen)
+{
+	screen->focus_changed = true;
+	schedule_update(NULL);
+}
+
+void
+screen_title_notify(struct screen *screen)
+{
+	uint64_t now, interval;
+
+	if (title_rate_hz == 0) {
+		stats_count(STATS_TITLES_DELIVERED);
+		screen_focus_notify(screen);
+		return;
+	}
+
+	/* A later change is already going to be delivered, and it will carry
+	 * this title along if it is still current. */
+	if (screen->title_pending) {
+		stats_count(STATS_TITLES_THROTTLED);
+		return;
+	}
+
+	now = now_ms();
+	interval = 1000 / title_rate_hz;
+
+	if (now - screen->last_title_time >= interval) {
+		screen->last_title_time = now;
+		stats_count(STATS_TITLES_DELIVERED);
+		screen_focus_notify(screen);
+		return;
+	}
+
+	if (!screen->title_timer) {
+		screen->title_timer = wl_event_loop_add_timer(velox.event_loop, &title_timer_expired, screen);
+		if (!screen->title_timer) {
+			screen_focus_notify(screen);
+			return;
+		}
+	}
+
+	/* The delay is always positive here, since 0 would disarm the timer. */
+	stats_count(STATS_TITLES_THROTTLED);
+	screen->title_pending = true;
+	wl_event_source_timer_update(screen->title_timer, interval - (now - screen->last_title_time));
+}
+
+void
+screen_flush(struct screen *screen)
 {
 	struct wl_resource *resource;
+	const char *title;
+	struct tag *tag;
+
+	if (!screen->focus_changed)
+		return;
 
-	wl_resource_for_each (resource, &screen->resources)
+	screen->focus_changed = false;
+	title = screen->focus ? screen->focus->swc->title : NULL;
+	tag = screen->focus ? screen->focus->tag : NULL;
+
+	/* Skip the event if clients already have this title and tag. Newly bound
+	 * resources are sent the focus when they are created. */
+	if (tag == screen->sent_tag && (title == screen->sent_title
+	    || (title && screen->sent_title && strcmp(title, screen->sent_title) == 0))) {
+		stats_count(STATS_TITLES_DUPLICATE);
+		return;
+	}
+
+	free(screen->sent_title);
+	screen->sent_title = title ? strdup(title) : NULL;
+	screen->sent_tag = tag;
+
+	wl_resource_for_each (resource, &screen->resources) {
 		send_focus(screen, resource);
+		send_done(resource);
+	}
 }
@@ -26,6 +26,7 @@
 
 #include "tag.h"
 #include "layout.h"
+#include "spatial.h"
 
 #include <wayland-server.h>
 
@@ -40,7 +41,7 @@ struct screen {
 	struct wl_list link;
 
 	struct wl_list tags;
-	uint32_t mask, last_mask;
+	struct tag_mask mask, last_mask;
 
 	struct wl_list layouts;
 	struct layout *layout[NUM_LAYERS];
@@ -49,23 +50,113 @@ struct screen {
 	unsigned num_windows[NUM_LAYERS];
 	struct window *focus;
 
+	/* The stacked windows, from bottom to top, and whether swc needs to be
+	 * told their order again on the next update. */
+	struct wl_list stack;
+	bool restack;
+
+	/* The width of the borders of the windows on this screen. */
+	unsigned border_width;
+
+	/* Whether the screen needs to be arranged on the next update. */
+	bool dirty;
+
+	/* The tiled windows as of the last arrange, and the closest screen in
+	 * each direction by usable geometry. */
+	struct spatial_index index;
+	struct screen *neighbors[NUM_DIRECTIONS];
+
 	struct wl_list resources;
+	/* Whether the focus event needs to be sent to clients. */
+	bool focus_changed;
+	/* The title and tag last sent in a focus event. */
+	char *sent_title;
+	struct tag *sent_tag;
+
+	/* Title changes are delivered at most screen.title_rate_hz times per
+	 * second, the last one after the timer expires. */
+	struct wl_event_source *title_timer;
+	bool title_pending;
+	uint64_t last_title_time;
 };
 
+bool screen_add_config_nodes();
+
 struct screen *screen_new(struct swc_screen *swc);
 
 void screen_arrange(struct screen *screen);
-void screen_set_tags(struct screen *screen, uint32_t tags);
+
+/**
+ * Configure the hidden tiled windows that would be shown if the screen
+ * switched back to its previous tags with the geometry they would get, so
+ * that their clients can resize before they are shown.
+ */
+void screen_preconfigure(struct screen *screen);
+
+/**
+ * Recompute the neighbours of every screen, after a screen was added or its
+ * usable geometry changed.
+ */
+void screen_update_neighbors();
+
+/**
+ * Focus the closest tiled window to the focus in the given direction, or
+ * activate the closest screen in the given direction.
+ */
+void screen_focus_direction(struct screen *screen, enum direction direction);
+void screen_activate_direction(struct screen *screen, enum direction direction);
+void screen_set_tags(struct screen *screen, const struct tag_mask *mask);
 
 void screen_focus_next(struct screen *screen);
 void screen_focus_prev(struct screen *screen);
 void screen_set_focus(struct screen *screen, struct window *window);
 
-void screen_add_windows(struct screen *screen);
-void screen_remove_windows(struct screen *screen);
+/**
+ * Move a stacked window to the top or bottom of the screen's stacking order.
+ * Tiled windows are always below the stacked ones.
+ */
+void screen_raise(struct screen *screen, struct window *window);
+void screen_lower(struct screen *screen, struct window *window);
+
+/**
+ * Show the stacked windows again from bottom to top, so that swc draws them
+ * in stacking order above the tiled windows.
+ */
+void screen_restack(struct screen *screen);
+
+/**
+ * Add a window to the end of the screen's window list, or remove it.
+ *
+ * The window's tag must already be on the screen when adding, and already be
+ * off of it when removing, so that a new focus can be chosen.
+ */
+void screen_add_window(struct screen *screen, struct window *window);
+void screen_remove_window(struct screen *screen, struct window *window);
+
+/**
+ * Add or remove all the windows with the given tag.
+ */
+void screen_add_windows(struct screen *screen, struct tag *tag);
+void screen_remove_windows(struct screen *screen, struct tag *tag);
 
 /* Wayland interface */
-struct wl_resource *screen_bind(struct screen *screen, struct wl_client *client, uint32_t id);
+struct wl_resource *screen_bind(struct screen *screen, struct wl_client *client,
+                                uint32_t version, uint32_t id);
+
+/**
+ * Queue a focus event to be sent to clients on the next flush.
+ */
 void screen_focus_notify(struct screen *screen);
 
+/**
+ * Queue a focus event because the title of the focused window changed, subject
+ * to the screen.title_rate_hz limit.
+ */
+void screen_title_notify(struct screen *screen);
+
+/**
+ * Send the queued focus event to all clients, followed by a done event.
+ */
+void screen_flush(struct screen *screen);
+
 #endif
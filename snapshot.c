@@ -0,0 +1,202 @@
+/* velox: snapshot.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* For memfd_create. */
+#define _GNU_SOURCE
+
+#include "snapshot.h"
+#include "screen.h"
+#include "stats.h"
+#include "tag.h"
+#include "util.h"
+#include "velox.h"
+#include "protocol/velox-server-protocol.h"
+#include "protocol/velox-snapshot.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <swc.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <unistd.h>
+
+/* Everything after the header is compared and copied as a whole. */
+#define STATE_OFFSET offsetof(struct velox_snapshot, num_screens)
+#define STATE_SIZE (sizeof(struct velox_snapshot) - STATE_OFFSET)
+
+/* Linux 5.1 added this seal, but older headers may not define it. */
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010
+#endif
+
+static struct velox_snapshot *shared;
+/* The shared memory, which is sent to clients. */
+static int fd = -1;
+static struct wl_list resources = { &resources, &resources };
+
+static bool
+create()
+{
+	if ((fd = memfd_create("velox-snapshot", MFD_CLOEXEC | MFD_ALLOW_SEALING)) == -1)
+		goto error0;
+
+	if (ftruncate(fd, sizeof *shared) == -1)
+		goto error1;
+
+	shared = mmap(NULL, sizeof *shared, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if (shared == MAP_FAILED)
+		goto error1;
+
+	/* Only our existing mapping may write to the memory from now on, and
+	 * clients may keep it mapped, so it must never change size under them.
+	 * Sealing the seals last means no client can undo this. */
+	if (fcntl(fd, F_ADD_SEALS, F_SEAL_FUTURE_WRITE | F_SEAL_SHRINK | F_SEAL_GROW) == -1
+	    || fcntl(fd, F_ADD_SEALS, F_SEAL_SEAL) == -1)
+		goto error2;
+
+	shared->version = VELOX_SNAPSHOT_VERSION;
+
+	return true;
+
+error2:
+	munmap(shared, sizeof *shared);
+	shared = NULL;
+error1:
+	close(fd);
+	fd = -1;
+error0:
+	return false;
+}
+
+static void
+fill(struct velox_snapshot *snapshot)
+{
+	struct velox_snapshot_screen *snapshot_screen;
+	struct screen *screen;
+	struct tag *tag;
+	unsigned index, num_screens = 0;
+
+	memset(snapshot, 0, sizeof *snapshot);
+	snapshot->active_screen = -1;
+	snapshot->num_tags = MIN(velox.num_tags, VELOX_SNAPSHOT_MAX_TAGS);
+
+	for (index = 0; index < snapshot->num_tags; ++index) {
+		tag = velox.tags[index];
+		snprintf(snapshot->tags[index].name, VELOX_SNAPSHOT_NAME_SIZE, "%s", tag->name);
+		snapshot->tags[index].num_windows = tag->num_windows;
+		snapshot->tags[index].screen = -1;
+	}
+
+	wl_list_for_each (screen, &velox.screens, link) {
+		if (num_screens == VELOX_SNAPSHOT_MAX_SCREENS)
+			break;
+
+		snapshot_screen = &snapshot->screens[num_screens];
+		snapshot_screen->x = screen->swc->usable_geometry.x;
+		snapshot_screen->y = screen->swc->usable_geometry.y;
+		snapshot_screen->width = screen->swc->usable_geometry.width;
+		snapshot_screen->height = screen->swc->usable_geometry.height;
+		memcpy(snapshot_screen->mask, screen->mask.words, MIN(sizeof snapshot_screen->mask, sizeof screen->mask.words));
+		snapshot_screen->focus_tag = screen->sent_tag ? (int32_t)screen->sent_tag->index : -1;
+		snapshot_screen->num_windows = screen->num_windows[TILE] + screen->num_windows[STACK];
+
+		/* The title clients were last sent, so that the snapshot agrees with
+		 * the title rate limit. */
+		if (screen->sent_title)
+			snprintf(snapshot_screen->title, VELOX_SNAPSHOT_TITLE_SIZE, "%s", screen->sent_title);
+
+		wl_list_for_each (tag, &screen->tags, link) {
+			if (tag->index < snapshot->num_tags)
+				snapshot->tags[tag->index].screen = num_screens;
+		}
+
+		if (screen == velox.active_screen)
+			snapshot->active_screen = num_screens;
+		++num_screens;
+	}
+
+	snapshot->num_screens = num_screens;
+}
+
+void
+snapshot_flush()
+{
+	static struct velox_snapshot next;
+	struct wl_resource *resource;
+	uint32_t sequence;
+
+	if (!shared || wl_list_empty(&resources))
+		return;
+
+	fill(&next);
+
+	if (memcmp((char *)&next + STATE_OFFSET, (char *)shared + STATE_OFFSET, STATE_SIZE) == 0)
+		return;
+
+	/* Readers retry while the sequence is odd, or if it changed while they
+	 * were copying. */
+	sequence = shared->sequence;
+	__atomic_store_n(&shared->sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy((char *)shared + STATE_OFFSET, (char *)&next + STATE_OFFSET, STATE_SIZE);
+	__atomic_store_n(&shared->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+	wl_resource_for_each (resource, &resources) {
+		velox_snapshot_send_changed(resource, sequence + 2);
+		stats_count(STATS_EVENTS);
+	}
+}
+
+static void
+destroy(struct wl_client *client, struct wl_resource *resource)
+{
+	wl_resource_destroy(resource);
+}
+
+static const struct velox_snapshot_interface snapshot_implementation = {
+	.destroy = &destroy,
+};
+
+bool
+snapshot_bind(struct wl_client *client, uint32_t version, uint32_t id)
+{
+	struct wl_resource *resource;
+
+	if (!shared && !create())
+		return false;
+
+	if (!(resource = wl_resource_create(client, &velox_snapshot_interface, version, id)))
+		return false;
+
+	wl_resource_set_implementation(resource, &snapshot_implementation, NULL, &remove_resource);
+	wl_list_insert(&resources, wl_resource_get_link(resource));
+	velox_snapshot_send_memory(resource, fd, sizeof *shared);
+
+	/* The snapshot isn't kept up to date while nobody is bound. */
+	snapshot_flush();
+
+	return true;
+}
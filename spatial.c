@@ -0,0 +1,228 @@
+/* velox: spatial.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "spatial.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/param.h>
+
+/* The edge of a rectangle that faces the given direction, and the one that
+ * faces away from it, both measured so that they grow in that direction. A
+ * rectangle is beyond another one if its near edge is at least the other's far
+ * edge. */
+static int64_t
+far_edge(const struct swc_rectangle *rect, enum direction direction)
+{
+	switch (direction) {
+	case DIRECTION_LEFT:
+		return -(int64_t)rect->x;
+	case DIRECTION_RIGHT:
+		return (int64_t)rect->x + rect->width;
+	case DIRECTION_UP:
+		return -(int64_t)rect->y;
+	default:
+		return (int64_t)rect->y + rect->height;
+	}
+}
+
+static int64_t
+near_edge(const struct swc_rectangle *rect, enum direction direction)
+{
+	switch (direction) {
+	case DIRECTION_LEFT:
+		return -((int64_t)rect->x + rect->width);
+	case DIRECTION_RIGHT:
+		return rect->x;
+	case DIRECTION_UP:
+		return -((int64_t)rect->y + rect->height);
+	default:
+		return rect->y;
+	}
+}
+
+/* The length of the overlap of two rectangles on the axis perpendicular to
+ * the direction. */
+static int64_t
+overlap(const struct swc_rectangle *a, const struct swc_rectangle *b, enum direction direction)
+{
+	int64_t start, end;
+
+	if (direction == DIRECTION_LEFT || direction == DIRECTION_RIGHT) {
+		start = MAX(a->y, b->y);
+		end = MIN((int64_t)a->y + a->height, (int64_t)b->y + b->height);
+	} else {
+		start = MAX(a->x, b->x);
+		end = MIN((int64_t)a->x + a->width, (int64_t)b->x + b->width);
+	}
+
+	return MAX(end - start, 0);
+}
+
+bool
+spatial_is_better(const struct swc_rectangle *from, const struct swc_rectangle *a,
+                  const struct swc_rectangle *b, enum direction direction)
+{
+	int64_t edge = far_edge(from, direction), a_overlap, b_overlap;
+
+	if (near_edge(a, direction) < edge)
+		return false;
+	if (!b)
+		return true;
+
+	a_overlap = overlap(from, a, direction);
+	b_overlap = overlap(from, b, direction);
+
+	if ((a_overlap > 0) != (b_overlap > 0))
+		return a_overlap > 0;
+	if (near_edge(a, direction) != near_edge(b, direction))
+		return near_edge(a, direction) < near_edge(b, direction);
+
+	return a_overlap > b_overlap;
+}
+
+void
+spatial_index_initialize(struct spatial_index *index)
+{
+	unsigned direction;
+
+	index->tiles = NULL;
+	for (direction = 0; direction < NUM_DIRECTIONS; ++direction)
+		index->order[direction] = NULL;
+	index->num_tiles = 0;
+	index->capacity = 0;
+	index->sorted = true;
+}
+
+static bool
+reserve(struct spatial_index *index, unsigned capacity)
+{
+	struct tile *tiles;
+	unsigned *order, direction;
+
+	if (capacity <= index->capacity)
+		return true;
+
+	capacity = MAX(capacity, index->capacity * 2);
+
+	if (!(tiles = realloc(index->tiles, capacity * sizeof *tiles)))
+		return false;
+	index->tiles = tiles;
+
+	for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+		if (!(order = realloc(index->order[direction], capacity * sizeof *order)))
+			return false;
+		index->order[direction] = order;
+	}
+
+	index->capacity = capacity;
+
+	return true;
+}
+
+bool
+spatial_index_update(struct spatial_index *index, struct window *const *windows,
+                     const struct swc_rectangle *rects, unsigned num_tiles)
+{
+	unsigned tile;
+
+	if (!reserve(index, num_tiles)) {
+		index->num_tiles = 0;
+		return false;
+	}
+
+	for (tile = 0; tile < num_tiles; ++tile) {
+		index->tiles[tile].window = windows[tile];
+		index->tiles[tile].geometry = rects[tile];
+	}
+
+	index->num_tiles = num_tiles;
+	index->sorted = false;
+
+	return true;
+}
+
+/* qsort has no way to pass these to the comparison function. */
+static const struct spatial_index *sort_index;
+static enum direction sort_direction;
+
+static int
+compare_tiles(const void *a, const void *b)
+{
+	int64_t a_edge = near_edge(&sort_index->tiles[*(const unsigned *)a].geometry, sort_direction),
+	        b_edge = near_edge(&sort_index->tiles[*(const unsigned *)b].geometry, sort_direction);
+
+	return (a_edge > b_edge) - (a_edge < b_edge);
+}
+
+static void
+sort(struct spatial_index *index)
+{
+	unsigned direction, tile;
+
+	sort_index = index;
+	for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+		for (tile = 0; tile < index->num_tiles; ++tile)
+			index->order[direction][tile] = tile;
+		sort_direction = direction;
+		qsort(index->order[direction], index->num_tiles, sizeof index->order[direction][0], &compare_tiles);
+	}
+
+	index->sorted = true;
+}
+
+struct window *
+spatial_index_find(struct spatial_index *index, const struct swc_rectangle *from, enum direction direction)
+{
+	const unsigned *order;
+	const struct tile *tile, *best = NULL;
+	int64_t edge = far_edge(from, direction);
+	unsigned low = 0, high = index->num_tiles, middle;
+
+	if (!index->sorted)
+		sort(index);
+
+	/* Find the first tile beyond from. */
+	order = index->order[direction];
+	while (low < high) {
+		middle = low + (high - low) / 2;
+		if (near_edge(&index->tiles[order[middle]].geometry, direction) < edge)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	/* Tiles are now visited from nearest to furthest, so once an overlapping
+	 * tile has been found, only the ones at the same distance can still be
+	 * better. */
+	for (; low < index->num_tiles; ++low) {
+		tile = &index->tiles[order[low]];
+		if (best && overlap(from, &best->geometry, direction) > 0
+		    && near_edge(&tile->geometry, direction) != near_edge(&best->geometry, direction))
+			break;
+		if (spatial_is_better(from, &tile->geometry, best ? &best->geometry : NULL, direction))
+			best = tile;
+	}
+
+	return best ? best->window : NULL;
+}
@@ -0,0 +1,84 @@
+/* velox: spatial.h
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VELOX_SPATIAL_H
+#define VELOX_SPATIAL_H
+
+#include <stdbool.h>
+#include <swc.h>
+
+struct window;
+
+enum direction {
+	DIRECTION_LEFT,
+	DIRECTION_RIGHT,
+	DIRECTION_UP,
+	DIRECTION_DOWN,
+
+	NUM_DIRECTIONS
+};
+
+struct tile {
+	struct window *window;
+	struct swc_rectangle geometry;
+};
+
+/* The tiles of a screen as of its last arrange. For each direction, the tiles
+ * are ordered by the edge facing away from it, so that their neighbours in
+ * that direction can be found with a binary search. The orders are only
+ * sorted once they are needed. */
+struct spatial_index {
+	struct tile *tiles;
+	unsigned *order[NUM_DIRECTIONS];
+	unsigned num_tiles, capacity;
+	bool sorted;
+};
+
+void spatial_index_initialize(struct spatial_index *index);
+
+/**
+ * Replace the tiles in the index with the given windows and their geometry.
+ */
+bool spatial_index_update(struct spatial_index *index, struct window *const *windows,
+                          const struct swc_rectangle *rects, unsigned num_tiles);
+
+/**
+ * Find the window whose tile is the closest neighbour of from in the given
+ * direction, or NULL if there is none. The windows in the index must still
+ * exist, so it should be refreshed before the query if windows may have
+ * gone away.
+ */
+struct window *spatial_index_find(struct spatial_index *index, const struct swc_rectangle *from,
+                                  enum direction direction);
+
+/**
+ * Determine whether a is beyond from in the given direction and a better
+ * neighbour than b, which may be NULL.
+ *
+ * Neighbours that overlap from on the other axis are preferred, then the
+ * closest ones, then the ones with the largest overlap.
+ */
+bool spatial_is_better(const struct swc_rectangle *from, const struct swc_rectangle *a,
+                       const struct swc_rectangle *b, enum direction direction);
+
+#endif
@@ -0,0 +1,142 @@
+/* velox: stats.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "stats.h"
+#include "util.h"
+#include "protocol/velox-server-protocol.h"
+
+#include <sys/param.h>
+#include <time.h>
+#include <wayland-server.h>
+
+#ifdef ENABLE_DEBUG
+
+struct stats stats;
+
+static const char *const timer_names[] = {
+	[STATS_MANAGE] = "manage",
+	[STATS_UPDATE] = "update",
+	[STATS_SET_TAGS] = "screen_set_tags",
+	[STATS_ACTION] = "action",
+};
+
+static const char *const counter_names[] = {
+	[STATS_CONFIGURES] = "configures",
+	[STATS_CONFIGURES_SKIPPED] = "configures_skipped",
+	[STATS_SHOWS] = "shows",
+	[STATS_HIDES] = "hides",
+	[STATS_EVENTS] = "events",
+	[STATS_TITLES_DELIVERED] = "titles_delivered",
+	[STATS_TITLES_THROTTLED] = "titles_throttled",
+	[STATS_TITLES_DUPLICATE] = "titles_duplicate",
+	[STATS_ANIMATION_MOVES] = "animation_moves",
+	[STATS_RESTACKS] = "restacks",
+};
+
+uint64_t
+stats_now()
+{
+	return now_ns();
+}
+
+void
+stats_record(enum stats_timer timer, uint64_t start)
+{
+	struct timer_stats *t = &stats.timers[timer];
+	uint64_t duration = stats_now() - start;
+	unsigned bucket = duration ? 63 - __builtin_clzll(duration) : 0;
+
+	++t->count;
+	t->total += duration;
+	t->max = MAX(t->max, duration);
+	++t->histogram[MIN(bucket, STATS_BUCKETS - 1)];
+	t->recent[t->next_recent] = MIN(duration, UINT32_MAX);
+	t->next_recent = (t->next_recent + 1) % STATS_RECENT;
+}
+
+void
+stats_print(FILE *file)
+{
+	const struct timer_stats *t;
+	unsigned index;
+
+	for (index = 0; index < NUM_STATS_TIMERS; ++index) {
+		t = &stats.timers[index];
+		fprintf(file, "%s: %lu calls, %.3f ms average, %.3f ms max\n", timer_names[index], t->count,
+		        t->count ? t->total / 1e6 / t->count : 0.0, t->max / 1e6);
+	}
+
+	for (index = 0; index < NUM_STATS_COUNTERS; ++index)
+		fprintf(file, "%s: %lu\n", counter_names[index], stats.counters[index]);
+}
+
+static void
+send_timer(struct wl_resource *resource, enum stats_timer timer)
+{
+	const struct timer_stats *t = &stats.timers[timer];
+	uint32_t recent[STATS_RECENT];
+	unsigned num_recent = MIN(t->count, STATS_RECENT), index;
+	struct wl_array histogram_array = {
+		.size = sizeof t->histogram,
+		.alloc = sizeof t->histogram,
+		.data = (void *)t->histogram,
+	};
+	struct wl_array recent_array = {
+		.size = num_recent * sizeof recent[0],
+		.alloc = sizeof recent,
+		.data = recent,
+	};
+
+	/* Unroll the ring buffer so that the oldest duration comes first. */
+	for (index = 0; index < num_recent; ++index)
+		recent[index] = t->recent[(t->next_recent + STATS_RECENT - num_recent + index) % STATS_RECENT];
+
+	velox_stats_send_timer(resource, timer_names[timer], t->count, MIN(t->total / 1000, UINT32_MAX),
+	                       MIN(t->max, UINT32_MAX), &histogram_array, &recent_array);
+}
+
+#endif
+
+bool
+stats_send(struct wl_client *client, uint32_t version, uint32_t id)
+{
+	struct wl_resource *resource;
+#ifdef ENABLE_DEBUG
+	unsigned index;
+#endif
+
+	if (!(resource = wl_resource_create(client, &velox_stats_interface, version, id)))
+		return false;
+
+#ifdef ENABLE_DEBUG
+	for (index = 0; index < NUM_STATS_TIMERS; ++index)
+		send_timer(resource, index);
+	for (index = 0; index < NUM_STATS_COUNTERS; ++index)
+		velox_stats_send_counter(resource, counter_names[index], MIN(stats.counters[index], UINT32_MAX));
+#endif
+
+	velox_stats_send_done(resource);
+	wl_resource_destroy(resource);
+
+	return true;
+}
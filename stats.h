@@ -0,0 +1,108 @@
+/* velox: stats.h
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VELOX_STATS_H
+#define VELOX_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+struct wl_client;
+
+enum stats_timer {
+	STATS_MANAGE,
+	STATS_UPDATE,
+	STATS_SET_TAGS,
+	STATS_ACTION,
+
+	NUM_STATS_TIMERS
+};
+
+enum stats_counter {
+	/* Calls to swc_window_set_geometry, and ones skipped because the
+	 * geometry was unchanged. */
+	STATS_CONFIGURES,
+	STATS_CONFIGURES_SKIPPED,
+	STATS_SHOWS,
+	STATS_HIDES,
+	/* Events sent to velox protocol clients. */
+	STATS_EVENTS,
+	/* Title changes that were delivered or merged into a later one by the
+	 * rate limit, and focus events that weren't sent because the title and
+	 * tag were unchanged. */
+	STATS_TITLES_DELIVERED,
+	STATS_TITLES_THROTTLED,
+	STATS_TITLES_DUPLICATE,
+	/* Animation frames that moved a window without configuring it. */
+	STATS_ANIMATION_MOVES,
+	/* Stacked windows shown again to put them back in stacking order. */
+	STATS_RESTACKS,
+
+	NUM_STATS_COUNTERS
+};
+
+#ifdef ENABLE_DEBUG
+
+/* Durations are counted in buckets by their power of two in nanoseconds, and
+ * the most recent ones are kept in a ring buffer. */
+#define STATS_BUCKETS 32
+#define STATS_RECENT 64
+
+struct timer_stats {
+	unsigned long count;
+	uint64_t total, max;
+	uint32_t histogram[STATS_BUCKETS];
+	uint32_t recent[STATS_RECENT];
+	unsigned next_recent;
+};
+
+extern struct stats {
+	struct timer_stats timers[NUM_STATS_TIMERS];
+	unsigned long counters[NUM_STATS_COUNTERS];
+} stats;
+
+/**
+ * Get the time to pass to stats_record once the timed code is done.
+ */
+uint64_t stats_now();
+void stats_record(enum stats_timer timer, uint64_t start);
+void stats_print(FILE *file);
+
+#define stats_count(counter) ((void)++stats.counters[counter])
+
+#else
+
+#define stats_now() 0
+#define stats_record(timer, start) ((void)(start))
+#define stats_print(file) ((void)0)
+#define stats_count(counter) ((void)0)
+
+#endif
+
+/**
+ * Create a velox_stats resource, send it the statistics and destroy it.
+ */
+bool stats_send(struct wl_client *client, uint32_t version, uint32_t id);
+
+#endif
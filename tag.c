@@ -24,6 +24,7 @@
 #include "tag.h"
 #include "layout.h"
 #include "screen.h"
+#include "stats.h"
 #include "util.h"
 #include "velox.h"
 #include "window.h"
@@ -36,18 +37,19 @@
 #include <swc.h>
 
 static CONFIG_GROUP(tag);
+static struct pool tags = POOL_INITIALIZER(struct tag);
 
-void
+bool
 tag_add_config_nodes()
 {
-	wl_list_insert(config_root, &tag_group.link);
+	return config_add_node(config_root, &tag_group);
 }
 
 static bool
 set_name(struct config_node *node, const char *value)
 {
-	struct tag *tag = wl_container_of(node, tag, config.name);
-	struct wl_resource *resource;
+	struct tag_config *config = wl_container_of(node, config, name);
+	struct tag *tag = config->tag;
 	char *name;
 
 	if (!(name = strdup(value)))
@@ -55,45 +57,75 @@ set_name(struct config_node *node, const char *value)
 
 	free(tag->name);
 	tag->name = name;
-
-	wl_resource_for_each (resource, &tag->resources)
-		velox_tag_send_name(resource, tag->name);
+	tag->changes |= TAG_CHANGE_NAME;
+	schedule_update(NULL);
 
 	return true;
 }
 
+static void
+get_name(struct config_node *node, char *value, size_t size)
+{
+	struct tag_config *config = wl_container_of(node, config, name);
+
+	snprintf(value, size, "%s", config->tag->name);
+}
+
 static void
 activate(struct config_node *node, const struct variant *v)
 {
-	struct tag *tag = wl_container_of(node, tag, config.activate);
+	struct tag_config *config = wl_container_of(node, config, activate);
+	struct tag *tag = config->tag;
 	struct screen *screen = velox.active_screen;
+	struct tag_mask mask = { 0 };
 
+	tag_mask_add(&mask, tag);
 	screen->last_mask = screen->mask;
-	screen_set_tags(screen, tag->mask);
-	update();
+	screen_set_tags(screen, &mask);
 }
 
 static void
 toggle(struct config_node *node, const struct variant *v)
 {
-	struct tag *tag = wl_container_of(node, tag, config.toggle);
+	struct tag_config *config = wl_container_of(node, config, toggle);
+	struct tag *tag = config->tag;
 	struct screen *screen = velox.active_screen;
+	struct tag_mask mask = screen->mask;
 
-	screen_set_tags(velox.active_screen, screen->mask ^ tag->mask);
-	update();
+	tag_mask_toggle(&mask, tag);
+	screen_set_tags(screen, &mask);
 }
 
 static void
 apply(struct config_node *node, const struct variant *v)
 {
-	struct tag *tag = wl_container_of(node, tag, config.apply);
+	struct tag_config *config = wl_container_of(node, config, apply);
+	struct tag *tag = config->tag;
 	struct window *w = window_or_focus(v);
 
 	if (!w)
 		return;
 
 	window_set_tag(w, tag);
-	update();
+}
+
+static void
+send_done(struct wl_resource *resource)
+{
+	if (wl_resource_get_version(resource) >= VELOX_TAG_DONE_SINCE_VERSION) {
+		velox_tag_send_done(resource);
+		stats_count(STATS_EVENTS);
+	}
+}
+
+static void
+send_screen(struct tag *tag, struct wl_resource *tag_resource, struct wl_resource *screen_resource)
+{
+	if (!screen_resource && tag->screen)
+		screen_resource = wl_resource_find_for_client(&tag->screen->resources, wl_resource_get_client(tag_resource));
+
+	velox_tag_send_screen(tag_resource, screen_resource);
+	stats_count(STATS_EVENTS);
 }
 
 static void
@@ -102,8 +134,8 @@ bind_tag(struct wl_client *client, void *data, uint32_t version, uint32_t id)
 	struct tag *tag = data;
 	struct wl_resource *resource;
 
-	if (version >= 1)
-		version = 1;
+	if (version >= 2)
+		version = 2;
 
 	resource = wl_resource_create(client, &velox_tag_interface, version, id);
 
@@ -115,8 +147,11 @@ bind_tag(struct wl_client *client, void *data, uint32_t version, uint32_t id)
 	wl_resource_set_destructor(resource, &remove_resource);
 	wl_list_insert(&tag->resources, wl_resource_get_link(resource));
 	velox_tag_send_name(resource, tag->name);
+	stats_count(STATS_EVENTS);
 	velox_tag_send_state(resource, tag->num_windows);
-	tag_send_screen(tag, client, resource, NULL);
+	stats_count(STATS_EVENTS);
+	send_screen(tag, resource, NULL);
+	send_done(resource);
 }
 
 struct tag *
@@ -124,53 +159,71 @@ tag_new(unsigned index, const char *name)
 {
 	struct tag *tag;
 
-	if (!(tag = malloc(sizeof *tag)))
+	if (!(tag = pool_alloc(&tags)))
 		goto error0;
 
 	if (!(tag->name = strdup(name)))
 		goto error1;
 
-	tag->mask = TAG_MASK(index);
+	tag->index = index;
 	tag->screen = NULL;
+	wl_list_init(&tag->windows);
 	tag->num_windows = 0;
-	tag->global = wl_global_create(velox.display, &velox_tag_interface, 1, tag, &bind_tag);
+	tag->global = wl_global_create(velox.display, &velox_tag_interface, 2, tag, &bind_tag);
 
 	if (!tag->global)
 		goto error2;
 
-	tag->config.group.name = strdup(tag->name);
-	tag->config.group.type = CONFIG_NODE_TYPE_GROUP;
-	wl_list_init(&tag->config.group.group);
-	wl_list_insert(&tag_group.group, &tag->config.group.link);
-
-	tag->config.name.name = "name";
-	tag->config.name.type = CONFIG_NODE_TYPE_PROPERTY;
-	tag->config.name.property.set = &set_name;
-	wl_list_insert(&tag->config.group.group, &tag->config.name.link);
-
-	tag->config.activate.name = "activate";
-	tag->config.activate.type = CONFIG_NODE_TYPE_ACTION;
-	tag->config.activate.action.run = &activate;
-	wl_list_insert(&tag->config.group.group, &tag->config.activate.link);
-
-	tag->config.toggle.name = "toggle";
-	tag->config.toggle.type = CONFIG_NODE_TYPE_ACTION;
-	tag->config.toggle.action.run = &toggle;
-	wl_list_insert(&tag->config.group.group, &tag->config.toggle.link);
-
-	tag->config.apply.name = "apply";
-	tag->config.apply.type = CONFIG_NODE_TYPE_ACTION;
-	tag->config.apply.action.run = &apply;
-	wl_list_insert(&tag->config.group.group, &tag->config.apply.link);
+	if (!(tag->config = config_alloc(sizeof *tag->config)))
+		goto error3;
+	if (!(tag->config->group.name = config_strdup(tag->name)))
+		goto error3;
+
+	tag->config->tag = tag;
+	tag->config->group.type = CONFIG_NODE_TYPE_GROUP;
+	wl_list_init(&tag->config->group.group.nodes);
+	tag->config->group.group.table = (struct hash_table){ 0 };
+	if (!config_add_node(&tag_group, &tag->config->group))
+		goto error3;
+
+	tag->config->name.name = "name";
+	tag->config->name.type = CONFIG_NODE_TYPE_PROPERTY;
+	tag->config->name.property.set = &set_name;
+	tag->config->name.property.get = &get_name;
+	tag->config->name.property.default_value = NULL;
+
+	tag->config->activate.name = "activate";
+	tag->config->activate.type = CONFIG_NODE_TYPE_ACTION;
+	tag->config->activate.action.run = &activate;
+
+	tag->config->toggle.name = "toggle";
+	tag->config->toggle.type = CONFIG_NODE_TYPE_ACTION;
+	tag->config->toggle.action.run = &toggle;
+
+	tag->config->apply.name = "apply";
+	tag->config->apply.type = CONFIG_NODE_TYPE_ACTION;
+	tag->config->apply.action.run = &apply;
+
+	if (!config_add_node(&tag->config->group, &tag->config->name)
+	    || !config_add_node(&tag->config->group, &tag->config->activate)
+	    || !config_add_node(&tag->config->group, &tag->config->toggle)
+	    || !config_add_node(&tag->config->group, &tag->config->apply))
+		goto error4;
 
 	wl_list_init(&tag->resources);
+	tag->changes = 0;
 
 	return tag;
 
+error4:
+	config_remove_node(&tag_group, &tag->config->group);
+	hash_table_finish(&tag->config->group.group.table);
+error3:
+	wl_global_destroy(tag->global);
 error2:
 	free(tag->name);
 error1:
-	free(tag);
+	pool_free(&tags, tag);
 error0:
 	return NULL;
 }
@@ -179,14 +232,62 @@ void
 tag_destroy(struct tag *tag)
 {
 	free(tag->name);
-	free(tag);
+	pool_free(&tags, tag);
 }
 
 void
-tag_add(struct tag *tag, struct screen *screen)
+tag_mask_add(struct tag_mask *mask, const struct tag *tag)
 {
-	struct wl_resource *resource;
+	mask->words[tag->index / 64] |= (uint64_t)1 << tag->index % 64;
+}
+
+void
+tag_mask_remove(struct tag_mask *mask, const struct tag *tag)
+{
+	mask->words[tag->index / 64] &= ~((uint64_t)1 << tag->index % 64);
+}
+
+void
+tag_mask_toggle(struct tag_mask *mask, const struct tag *tag)
+{
+	mask->words[tag->index / 64] ^= (uint64_t)1 << tag->index % 64;
+}
 
+bool
+tag_mask_has(const struct tag_mask *mask, const struct tag *tag)
+{
+	return mask->words[tag->index / 64] >> tag->index % 64 & 1;
+}
+
+bool
+tag_mask_is_empty(const struct tag_mask *mask)
+{
+	unsigned word;
+
+	for (word = 0; word < TAG_MASK_WORDS; ++word) {
+		if (mask->words[word])
+			return false;
+	}
+
+	return true;
+}
+
+bool
+tag_mask_equal(const struct tag_mask *a, const struct tag_mask *b)
+{
+	unsigned word;
+
+	for (word = 0; word < TAG_MASK_WORDS; ++word) {
+		if (a->words[word] != b->words[word])
+			return false;
+	}
+
+	return true;
+}
+
+void
+tag_add(struct tag *tag, struct screen *screen)
+{
 	assert(tag->screen == NULL);
 
 	/* Add the tag to the end of the tag list to minimize churn of the screen's
@@ -194,12 +295,12 @@ tag_add(struct tag *tag, struct screen *screen)
 	wl_list_insert(screen ? screen->tags.prev : &velox.unused_tags, &tag->link);
 
 	if (screen) {
-		screen->mask |= tag->mask;
+		tag_mask_add(&screen->mask, tag);
 		tag->screen = screen;
 	}
 
-	wl_resource_for_each (resource, &tag->resources)
-		tag_send_screen(tag, wl_resource_get_client(resource), resource, NULL);
+	tag->changes |= TAG_CHANGE_SCREEN;
+	schedule_update(NULL);
 }
 
 void
@@ -210,7 +311,7 @@ tag_remove(struct tag *tag, struct screen *screen)
 	wl_list_remove(&tag->link);
 
 	if (screen) {
-		screen->mask &= ~tag->mask;
+		tag_mask_remove(&screen->mask, tag);
 		tag->screen = NULL;
 	}
 }
@@ -229,24 +330,42 @@ void
 tag_send_screen(struct tag *tag, struct wl_client *client,
                 struct wl_resource *tag_resource, struct wl_resource *screen_resource)
 {
-	if (!tag_resource)
-		tag_resource = wl_resource_find_for_client(&tag->resources, client);
-
-	if (!screen_resource) {
-		screen_resource = tag->screen
-		                      ? wl_resource_find_for_client(&tag->screen->resources, client)
-		                      : NULL;
-	}
+	if (!tag_resource && !(tag_resource = wl_resource_find_for_client(&tag->resources, client)))
+		return;
 
-	velox_tag_send_screen(tag_resource, screen_resource);
+	send_screen(tag, tag_resource, screen_resource);
+	send_done(tag_resource);
 }
 
 void
 tag_update_num_windows(struct tag *tag, int change)
+{
+	tag->num_windows += change;
+	tag->changes |= TAG_CHANGE_STATE;
+	schedule_update(NULL);
+}
+
+void
+tag_flush(struct tag *tag)
 {
 	struct wl_resource *resource;
 
-	tag->num_windows += change;
-	wl_resource_for_each (resource, &tag->resources)
-		velox_tag_send_state(resource, tag->num_windows);
+	if (!tag->changes)
+		return;
+
+	wl_resource_for_each (resource, &tag->resources) {
+		if (tag->changes & TAG_CHANGE_NAME) {
+			velox_tag_send_name(resource, tag->name);
+			stats_count(STATS_EVENTS);
+		}
+		if (tag->changes & TAG_CHANGE_STATE) {
+			velox_tag_send_state(resource, tag->num_windows);
+			stats_count(STATS_EVENTS);
+		}
+		if (tag->changes & TAG_CHANGE_SCREEN)
+			send_screen(tag, resource, NULL);
+		send_done(resource);
+	}
+
+	tag->changes = 0;
 }
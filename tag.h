@@ -25,30 +25,51 @@
 #define VELOX_TAG_H
 
 #include "config.h"
+#include "velox.h"
 
 #include <stdbool.h>
 #include <wayland-server.h>
 
-#define TAG_MASK(n) (1 << (n))
-
 struct window;
 
+enum {
+	TAG_CHANGE_NAME = 1 << 0,
+	TAG_CHANGE_STATE = 1 << 1,
+	TAG_CHANGE_SCREEN = 1 << 2,
+};
+
+struct tag_config {
+	struct config_node group, name, activate, toggle, apply;
+	struct tag *tag;
+};
+
 struct tag {
 	char *name;
-	uint32_t mask;
+	unsigned index;
 	struct screen *screen;
 	struct wl_list link;
+
+	/* The windows with this tag, in the order they were tagged. */
+	struct wl_list windows;
 	unsigned num_windows;
 
 	struct wl_global *global;
 	struct wl_list resources;
+	/* The TAG_CHANGE_* events that haven't been sent to clients yet. */
+	unsigned changes;
 
-	struct {
-		struct config_node group, name, activate, toggle, apply;
-	} config;
+	/* Allocated with the rest of the config tree. */
+	struct tag_config *config;
 };
 
-void tag_add_config_nodes();
+bool tag_add_config_nodes();
+
+void tag_mask_add(struct tag_mask *mask, const struct tag *tag);
+void tag_mask_remove(struct tag_mask *mask, const struct tag *tag);
+void tag_mask_toggle(struct tag_mask *mask, const struct tag *tag);
+bool tag_mask_has(const struct tag_mask *mask, const struct tag *tag);
+bool tag_mask_is_empty(const struct tag_mask *mask);
+bool tag_mask_equal(const struct tag_mask *a, const struct tag_mask *b);
 
 struct tag *tag_new(unsigned index, const char *name);
 void tag_destroy(struct tag *tag);
@@ -76,7 +97,7 @@ void tag_remove(struct tag *tag, struct screen *screen);
 void tag_set(struct tag *tag, struct screen *screen);
 
 /**
- * Send a screen event for this tag.
+ * Send a screen event for this tag, followed by a done event.
  *
  * Either tag_resource, screen_resource, or both may be NULL in which case the
  * correct resource is found using client.
@@ -86,4 +107,10 @@ void tag_send_screen(struct tag *tag, struct wl_client *client,
 
 void tag_update_num_windows(struct tag *tag, int change);
 
+/**
+ * Send the events for the changes queued since the last flush to all clients,
+ * each followed by a done event.
+ */
+void tag_flush(struct tag *tag);
+
 #endif
@@ -0,0 +1,146 @@
+/* velox: trace.c
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "trace.h"
+#include "util.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Events are queued in a single-producer, single-consumer ring, which the
+ * writer thread drains to the trace file, so that the compositor never waits
+ * on the disk. If the ring fills up, new events are dropped. */
+#define RING_SIZE 65536
+
+struct event {
+	const char *name;
+	uint64_t time;
+	char phase;
+};
+
+bool trace_enabled;
+
+static struct {
+	struct event events[RING_SIZE];
+	/* head is only written by the compositor, and tail by the writer. */
+	unsigned head, tail;
+} ring;
+
+static FILE *file;
+static pthread_t thread;
+static bool stopping;
+static unsigned long dropped;
+static uint64_t start_time;
+
+void
+trace_event(const char *name, char phase)
+{
+	unsigned head = ring.head, tail = __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE);
+
+	if (head - tail == RING_SIZE) {
+		++dropped;
+		return;
+	}
+
+	ring.events[head % RING_SIZE] = (struct event){ name, now_ns(), phase };
+	__atomic_store_n(&ring.head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void *
+write_events(void *data)
+{
+	static const struct timespec interval = { 0, 10000000 };
+	const struct event *event;
+	long pid = getpid();
+	unsigned head, tail = 0;
+	bool stop, first = true;
+
+	for (;;) {
+		/* Check for stopping first, so that the events queued before it
+		 * are still written out. */
+		stop = __atomic_load_n(&stopping, __ATOMIC_ACQUIRE);
+		head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+
+		for (; tail != head; ++tail) {
+			event = &ring.events[tail % RING_SIZE];
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%ld,\"tid\":1}",
+			        first ? "" : ",\n", event->name, event->phase,
+			        (event->time - start_time) / 1e3, pid);
+			first = false;
+		}
+		__atomic_store_n(&ring.tail, tail, __ATOMIC_RELEASE);
+
+		if (stop)
+			break;
+
+		fflush(file);
+		nanosleep(&interval, NULL);
+	}
+
+	return NULL;
+}
+
+void
+trace_initialize()
+{
+	const char *path;
+
+	if (!(path = getenv("VELOX_TRACE")) || !*path)
+		return;
+
+	if (!(file = fopen(path, "w"))) {
+		fprintf(stderr, "Could not open trace file '%s'\n", path);
+		return;
+	}
+
+	fputs("{\"traceEvents\":[\n", file);
+	start_time = now_ns();
+
+	if (thread_create(&thread, &write_events, NULL) != 0) {
+		fprintf(stderr, "Could not start trace writer thread\n");
+		fclose(file);
+		return;
+	}
+
+	trace_enabled = true;
+}
+
+void
+trace_finalize()
+{
+	if (!trace_enabled)
+		return;
+
+	trace_enabled = false;
+	__atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+	pthread_join(thread, NULL);
+	fputs("\n]}\n", file);
+	fclose(file);
+
+	if (dropped > 0)
+		fprintf(stderr, "Dropped %lu trace events\n", dropped);
+}
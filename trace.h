@@ -0,0 +1,49 @@
+/* velox: trace.h
+ *
+ * Copyright (c) 2014 Michael Forney
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VELOX_TRACE_H
+#define VELOX_TRACE_H
+
+#include <stdbool.h>
+
+extern bool trace_enabled;
+
+/**
+ * Start writing a Chrome trace to the file named by the VELOX_TRACE
+ * environment variable, if it is set.
+ */
+void trace_initialize();
+
+/**
+ * Write out the remaining events and close the trace.
+ */
+void trace_finalize();
+
+void trace_event(const char *name, char phase);
+
+/* Mark the beginning and end of a span on the trace timeline. The name is
+ * not copied, so it should be a string literal. */
+#define trace_begin(name) (trace_enabled ? trace_event(name, 'B') : (void)0)
+#define trace_end(name) (trace_enabled ? trace_event(name, 'E') : (void)0)
+
+#endif
@@ -23,6 +23,10 @@
 
 #include "util.h"
 
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <wayland-server.h>
 
 void
@@ -30,3 +34,365 @@ remove_resource(struct wl_resource *resource)
 {
 	wl_list_remove(wl_resource_get_link(resource));
 }
+
+double
+elapsed_ms(const struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (end.tv_sec - start->tv_sec) * 1e3 + (end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+uint64_t
+now_ms()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+uint64_t
+now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int
+thread_create(pthread_t *thread, void *(*start)(void *), void *data)
+{
+	sigset_t mask, old_mask;
+	int error;
+
+	/* The new thread inherits the signal mask of this one. */
+	sigfillset(&mask);
+	pthread_sigmask(SIG_BLOCK, &mask, &old_mask);
+	error = pthread_create(thread, NULL, start, data);
+	pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+
+	return error;
+}
+
+enum {
+	ARENA_BLOCK_SIZE = 16384,
+	ARENA_ALIGNMENT = 2 * sizeof(void *),
+};
+
+struct arena_block {
+	struct arena_block *next;
+	size_t size, used;
+};
+
+#define ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+void
+arena_init(struct arena *arena)
+{
+	arena->block = NULL;
+}
+
+void
+arena_finish(struct arena *arena)
+{
+	struct arena_block *block, *next;
+
+	for (block = arena->block; block; block = next) {
+		next = block->next;
+		free(block);
+	}
+
+	arena->block = NULL;
+}
+
+void *
+arena_alloc(struct arena *arena, size_t size)
+{
+	struct arena_block *block = arena->block;
+	size_t block_size;
+	void *data;
+
+	size = ALIGN(size);
+
+	if (!block || block->size - block->used < size) {
+		block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+
+		if (!(block = malloc(ALIGN(sizeof *block) + block_size)))
+			return NULL;
+
+		block->size = block_size;
+		block->used = 0;
+		block->next = arena->block;
+		arena->block = block;
+	}
+
+	data = (char *)block + ALIGN(sizeof *block) + block->used;
+	block->used += size;
+
+	return data;
+}
+
+char *
+arena_strdup(struct arena *arena, const char *s)
+{
+	size_t len = strlen(s) + 1;
+	char *copy;
+
+	if ((copy = arena_alloc(arena, len)))
+		memcpy(copy, s, len);
+
+	return copy;
+}
+
+enum {
+	POOL_CHUNK_LENGTH = 64,
+};
+
+struct pool_slot {
+	uint32_t index, generation;
+	/* One more than the index of the next free slot, if this one is free. */
+	uint32_t next;
+	bool used;
+};
+
+#define SLOT_HEADER_SIZE ALIGN(sizeof(struct pool_slot))
+#define SLOT_OBJECT(slot) ((char *)(slot) + SLOT_HEADER_SIZE)
+#define OBJECT_SLOT(object) ((struct pool_slot *)((char *)(object) - SLOT_HEADER_SIZE))
+
+static size_t
+slot_size(struct pool *pool)
+{
+	return SLOT_HEADER_SIZE + ALIGN(pool->size);
+}
+
+static struct pool_slot *
+pool_slot(struct pool *pool, uint32_t index)
+{
+	char *chunk = pool->chunks[index / POOL_CHUNK_LENGTH];
+
+	return (struct pool_slot *)(chunk + index % POOL_CHUNK_LENGTH * slot_size(pool));
+}
+
+void
+pool_finish(struct pool *pool)
+{
+	uint32_t index;
+
+	for (index = 0; index < pool->num_chunks; ++index)
+		free(pool->chunks[index]);
+	free(pool->chunks);
+	pool->chunks = NULL;
+	pool->num_chunks = 0;
+	pool->free = 0;
+}
+
+static bool
+pool_grow(struct pool *pool)
+{
+	struct pool_slot *slot;
+	char **chunks, *chunk;
+	uint32_t index, base;
+
+	if (!(chunk = malloc(POOL_CHUNK_LENGTH * slot_size(pool))))
+		goto error0;
+	if (!(chunks = realloc(pool->chunks, (pool->num_chunks + 1) * sizeof *chunks)))
+		goto error1;
+
+	pool->chunks = chunks;
+	pool->chunks[pool->num_chunks] = chunk;
+	base = pool->num_chunks++ * POOL_CHUNK_LENGTH;
+
+	/* Thread the new slots onto the free list so they are used in order. */
+	for (index = base + POOL_CHUNK_LENGTH; index > base; --index) {
+		slot = pool_slot(pool, index - 1);
+		slot->index = index - 1;
+		slot->generation = 1;
+		slot->used = false;
+		slot->next = pool->free;
+		pool->free = index;
+	}
+
+	return true;
+
+error1:
+	free(chunk);
+error0:
+	return false;
+}
+
+void *
+pool_alloc(struct pool *pool)
+{
+	struct pool_slot *slot;
+
+	if (pool->free == 0 && !pool_grow(pool))
+		return NULL;
+
+	slot = pool_slot(pool, pool->free - 1);
+	pool->free = slot->next;
+	slot->used = true;
+
+	return SLOT_OBJECT(slot);
+}
+
+void
+pool_free(struct pool *pool, void *object)
+{
+	struct pool_slot *slot = OBJECT_SLOT(object);
+
+	slot->used = false;
+	/* Skip generation 0 so that zeroed handles stay invalid. */
+	if (++slot->generation == 0)
+		slot->generation = 1;
+	slot->next = pool->free;
+	pool->free = slot->index + 1;
+}
+
+struct handle
+pool_handle(struct pool *pool, void *object)
+{
+	struct pool_slot *slot = OBJECT_SLOT(object);
+
+	return (struct handle){ slot->index, slot->generation };
+}
+
+void *
+pool_get(struct pool *pool, struct handle handle)
+{
+	struct pool_slot *slot;
+
+	if (handle.index / POOL_CHUNK_LENGTH >= pool->num_chunks)
+		return NULL;
+
+	slot = pool_slot(pool, handle.index);
+
+	return slot->used && slot->generation == handle.generation ? SLOT_OBJECT(slot) : NULL;
+}
+
+uint32_t
+hash_string(const char *s, size_t len)
+{
+	uint32_t hash = 2166136261;
+
+	/* FNV-1a */
+	while (len--) {
+		hash ^= (unsigned char)*s++;
+		hash *= 16777619;
+	}
+
+	return hash;
+}
+
+bool
+hash_table_init(struct hash_table *table)
+{
+	table->size = 16;
+	table->count = 0;
+	table->buckets = calloc(table->size, sizeof *table->buckets);
+
+	return table->buckets;
+}
+
+void
+hash_table_finish(struct hash_table *table)
+{
+	free(table->buckets);
+	table->buckets = NULL;
+	table->size = 0;
+	table->count = 0;
+}
+
+static bool
+grow(struct hash_table *table)
+{
+	struct hash_entry **buckets, *entry, *next, **tail;
+	unsigned index, size = table->size * 2;
+
+	if (!(buckets = calloc(size, sizeof *buckets)))
+		return false;
+
+	/* Walk each old chain in order, appending to the new chains so that entries
+	 * with equal keys stay in insertion order. */
+	for (index = 0; index < table->size; ++index) {
+		for (entry = table->buckets[index]; entry; entry = next) {
+			next = entry->next;
+			for (tail = &buckets[entry->hash & (size - 1)]; *tail; tail = &(*tail)->next)
+				;
+			entry->next = NULL;
+			*tail = entry;
+		}
+	}
+
+	free(table->buckets);
+	table->buckets = buckets;
+	table->size = size;
+
+	return true;
+}
+
+bool
+hash_table_insert(struct hash_table *table, struct hash_entry *entry)
+{
+	struct hash_entry **tail;
+
+	if (table->count >= table->size && !grow(table))
+		return false;
+
+	entry->hash = hash_string(entry->key, strlen(entry->key));
+	entry->next = NULL;
+	for (tail = &table->buckets[entry->hash & (table->size - 1)]; *tail; tail = &(*tail)->next)
+		;
+	*tail = entry;
+	++table->count;
+
+	return true;
+}
+
+void
+hash_table_remove(struct hash_table *table, struct hash_entry *entry)
+{
+	struct hash_entry **link;
+
+	for (link = &table->buckets[entry->hash & (table->size - 1)]; *link; link = &(*link)->next) {
+		if (*link == entry) {
+			*link = entry->next;
+			--table->count;
+			return;
+		}
+	}
+}
+
+struct hash_entry *
+hash_table_lookup(struct hash_table *table, const char *key, size_t len)
+{
+	struct hash_entry *entry;
+	uint32_t hash;
+
+	if (table->size == 0)
+		return NULL;
+
+	hash = hash_string(key, len);
+	for (entry = table->buckets[hash & (table->size - 1)]; entry; entry = entry->next) {
+		if (entry->hash == hash && strncmp(entry->key, key, len) == 0 && entry->key[len] == '\0')
+			return entry;
+	}
+
+	return NULL;
+}
+
+struct hash_entry *
+hash_table_lookup_next(struct hash_entry *entry)
+{
+	struct hash_entry *next;
+
+	for (next = entry->next; next; next = next->next) {
+		if (next->hash == entry->hash && strcmp(next->key, entry->key) == 0)
+			return next;
+	}
+
+	return NULL;
+}
@@ -24,10 +24,119 @@
 #ifndef VELOX_UTIL_H
 #define VELOX_UTIL_H
 
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #define ARRAY_LENGTH(array) (sizeof array / sizeof array[0])
 
+struct timespec;
 struct wl_resource;
 
 void remove_resource(struct wl_resource *resource);
 
+/**
+ * Get the number of milliseconds on the monotonic clock since start.
+ */
+double elapsed_ms(const struct timespec *start);
+
+/**
+ * Get the time on the monotonic clock in milliseconds.
+ */
+uint64_t now_ms();
+uint64_t now_ns();
+
+/**
+ * Start a thread with all signals blocked, since they are handled by the event
+ * loop on the main thread. Returns 0 or an error number, like pthread_create.
+ */
+int thread_create(pthread_t *thread, void *(*start)(void *), void *data);
+
+/* Arenas */
+struct arena_block;
+
+/**
+ * A collection of allocations that are all freed at once.
+ */
+struct arena {
+	struct arena_block *block;
+};
+
+void arena_init(struct arena *arena);
+void arena_finish(struct arena *arena);
+void *arena_alloc(struct arena *arena, size_t size);
+char *arena_strdup(struct arena *arena, const char *s);
+
+/* Pools */
+
+/**
+ * A reference to an object in a pool, which becomes invalid when the object is
+ * freed, even if its memory is reused for another object. A zeroed handle
+ * never refers to an object.
+ */
+struct handle {
+	uint32_t index, generation;
+};
+
+/**
+ * Fixed size objects allocated from chunks of slots, which are never returned
+ * to the system. Freed slots are reused by later allocations.
+ */
+struct pool {
+	size_t size;
+	char **chunks;
+	/* One more than the index of the first free slot, or 0 if there is none. */
+	uint32_t num_chunks, free;
+};
+
+#define POOL_INITIALIZER(type) { .size = sizeof(type) }
+
+void pool_finish(struct pool *pool);
+void *pool_alloc(struct pool *pool);
+void pool_free(struct pool *pool, void *object);
+
+struct handle pool_handle(struct pool *pool, void *object);
+
+/**
+ * Get the object that a handle refers to, or NULL if it has been freed.
+ */
+void *pool_get(struct pool *pool, struct handle handle);
+
+/* Hash tables */
+struct hash_entry {
+	const char *key;
+	uint32_t hash;
+	struct hash_entry *next;
+};
+
+struct hash_table {
+	struct hash_entry **buckets;
+	unsigned size, count;
+};
+
+uint32_t hash_string(const char *s, size_t len);
+
+bool hash_table_init(struct hash_table *table);
+void hash_table_finish(struct hash_table *table);
+
+/**
+ * Insert an entry into the table using entry->key, which must stay valid for as
+ * long as the entry is in the table.
+ *
+ * Entries with equal keys are kept in insertion order.
+ */
+bool hash_table_insert(struct hash_table *table, struct hash_entry *entry);
+void hash_table_remove(struct hash_table *table, struct hash_entry *entry);
+
+/**
+ * Find the first entry whose key is equal to the first len bytes of key.
+ */
+struct hash_entry *hash_table_lookup(struct hash_table *table, const char *key, size_t len);
+
+/**
+ * Find the next entry after entry with an equal key.
+ */
+struct hash_entry *hash_table_lookup_next(struct hash_entry *entry);
+
 #endif
@@ -23,23 +23,30 @@
  */
 
 #include "velox.h"
+#include "animation.h"
 #include "config.h"
 #include "layout.h"
+#include "process.h"
 #include "screen.h"
+#include "snapshot.h"
+#include "stats.h"
 #include "tag.h"
+#include "trace.h"
 #include "window.h"
 #include "protocol/velox-server-protocol.h"
 
 #include <signal.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <swc.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 #include <wayland-server.h>
 #include <xkbcommon/xkbcommon.h>
 
-struct velox velox;
+struct velox velox = { .num_tags = DEFAULT_NUM_TAGS };
 unsigned border_width = 2;
 
 static void
@@ -52,6 +59,7 @@ new_screen(struct swc_screen *swc)
 
 	velox.active_screen = screen;
 	wl_list_insert(&velox.screens, &screen->link);
+	screen_update_neighbors();
 }
 
 static void
@@ -59,10 +67,10 @@ new_window(struct swc_window *swc)
 {
 	struct window *window;
 
-	if (!(window = window_new(swc)))
-		return;
-
-	manage(window);
+	trace_begin("new_window");
+	if ((window = window_new(swc)))
+		manage(window);
+	trace_end("new_window");
 }
 
 const struct swc_manager manager = {
@@ -86,63 +94,86 @@ get_screen(struct wl_client *client, struct wl_resource *resource,
 	return;
 
 found:
-	if (!screen_bind(screen, client, id))
+	if (!screen_bind(screen, client, wl_resource_get_version(resource), id))
 		wl_client_post_no_memory(client);
 }
 
-static const struct velox_interface velox_implementation = {
-	.get_screen = &get_screen,
-};
+static void
+get_stats(struct wl_client *client, struct wl_resource *resource, uint32_t id)
+{
+	if (!stats_send(client, wl_resource_get_version(resource), id))
+		wl_client_post_no_memory(client);
+}
 
 static void
-apply_rules(struct window *window)
+get_snapshot(struct wl_client *client, struct wl_resource *resource, uint32_t id)
 {
-	struct rule *rule;
-	const char *identifier;
+	if (!snapshot_bind(client, wl_resource_get_version(resource), id))
+		wl_client_post_no_memory(client);
+}
 
-	wl_list_for_each (rule, &velox.rules, link) {
-		switch (rule->type) {
-		case RULE_TYPE_WINDOW_TITLE:
-			identifier = window->swc->title;
-			break;
-		case RULE_TYPE_APP_ID:
-			identifier = window->swc->app_id;
-			break;
-		default:
-			identifier = NULL;
-			break;
-		}
+static void
+run_commands(struct wl_client *client, struct wl_resource *resource, uint32_t id, const char *commands)
+{
+	struct wl_resource *command_resource;
+	char *copy, *command, *s;
+	unsigned index = 0;
 
-		if (!identifier)
-			continue;
+	if (!(command_resource = wl_resource_create(client, &velox_command_interface, wl_resource_get_version(resource), id)))
+		goto error0;
 
-		if (strcmp(identifier, rule->identifier) == 0) {
-			struct config_node *node = rule->action;
-			const struct variant v = {
-				.type = VARIANT_WINDOW,
-				.window = window
-			};
+	if (!(copy = strdup(commands)))
+		goto error1;
 
-			node->action.run(node, &v);
+	trace_begin("run_commands");
+	for (s = copy; (command = strtok_r(s, "\n", &s));) {
+		/* Lines with nothing but spaces and tabs are blank too. */
+		if (command[strspn(command, " \t")] == '\0')
+			continue;
+		if (!config_run_command(command)) {
+			velox_command_send_failed(command_resource, index);
+			break;
 		}
+		++index;
 	}
+	trace_end("run_commands");
+
+	/* The actions only schedule updates, so the windows are arranged once
+	 * all of them have run. */
+	free(copy);
+	velox_command_send_done(command_resource, index);
+	wl_resource_destroy(command_resource);
+
+	return;
+
+error1:
+	wl_resource_destroy(command_resource);
+error0:
+	wl_client_post_no_memory(client);
 }
 
+static const struct velox_interface velox_implementation = {
+	.get_screen = &get_screen,
+	.get_stats = &get_stats,
+	.get_snapshot = &get_snapshot,
+	.run_commands = &run_commands,
+};
+
 void
 manage(struct window *window)
 {
 	struct tag *tag;
+	uint64_t start = stats_now();
 
-	wl_list_insert(&velox.hidden_windows, &window->link);
-
-	apply_rules(window);
+	window_apply_rules(window);
 	if (!window->tag) {
 		tag = wl_container_of(velox.active_screen->tags.next, tag, link);
 		window_set_tag(window, tag);
 	}
 	if (window->tag->screen)
 		screen_set_focus(window->tag->screen, window);
-	update();
+	schedule_update(window->tag->screen);
+	stats_record(STATS_MANAGE, start);
 }
 
 void
@@ -151,9 +182,30 @@ unmanage(struct window *window)
 	struct screen *screen = window->tag->screen;
 
 	window_set_tag(window, NULL);
-	wl_list_remove(&window->link);
+	wl_list_remove(&window->visibility_link);
 	if (screen)
-		screen_arrange(screen);
+		schedule_update(screen);
+}
+
+static void
+handle_update(void *data)
+{
+	velox.update_source = NULL;
+	update();
+}
+
+void
+schedule_update(struct screen *screen)
+{
+	if (screen)
+		screen->dirty = true;
+
+	if (!velox.update_source)
+		velox.update_source = wl_event_loop_add_idle(velox.event_loop, &handle_update, NULL);
+
+	/* If we couldn't defer the update, fall back to doing it right away. */
+	if (!velox.update_source)
+		update();
 }
 
 void
@@ -162,41 +214,92 @@ arrange()
 	struct screen *screen;
 
 	wl_list_for_each (screen, &velox.screens, link)
-		screen_arrange(screen);
+		schedule_update(screen);
 }
 
 void
 update()
 {
 	struct screen *screen;
-	struct window *window;
+	static struct screen *preconfigured_screen;
+	struct window *window, *tmp;
+	unsigned index;
+	bool active_arranged = velox.active_screen && velox.active_screen->dirty;
+	uint64_t start = stats_now();
 
 	/* Arrange the windows first so that they aren't shown before they are the
 	 * correct size. */
-	arrange();
-
 	wl_list_for_each (screen, &velox.screens, link) {
-		wl_list_for_each (window, &screen->windows, link)
+		if (!screen->dirty)
+			continue;
+		screen_arrange(screen);
+		screen->dirty = false;
+	}
+
+	/* Only windows that were added to or removed from a screen, or covered or
+	 * uncovered by its layout, since the last update need to be shown or
+	 * hidden. */
+	wl_list_for_each_safe (window, tmp, &velox.visibility_changes, visibility_link) {
+		wl_list_remove(&window->visibility_link);
+		wl_list_init(&window->visibility_link);
+
+		if (window_should_show(window) == window->shown)
+			continue;
+
+		if (window->shown) {
+			window_hide(window);
+		} else {
 			window_show(window);
+
+			/* swc now draws the window above the stacked windows of its
+			 * screen, unless it is the top one. */
+			screen = window->tag->screen;
+			if (window->layer == TILE ? !wl_list_empty(&screen->stack) : window->stack_link.next != &screen->stack)
+				screen->restack = true;
+		}
 	}
 
-	wl_list_for_each (window, &velox.hidden_windows, link)
-		window_hide(window);
+	wl_list_for_each (screen, &velox.screens, link) {
+		if (screen->restack)
+			screen_restack(screen);
+	}
+
+	/* Get the windows that the active screen would show on previous_tags
+	 * ready, once the hidden ones are out of sight. */
+	if (velox.active_screen && (active_arranged || velox.active_screen != preconfigured_screen)) {
+		screen_preconfigure(velox.active_screen);
+		preconfigured_screen = velox.active_screen;
+	}
+
+	/* Send the protocol events queued since the last update in one batch, so
+	 * clients see a single change for a burst of events. */
+	trace_begin("flush");
+	for (index = 0; index < velox.num_tags; ++index)
+		tag_flush(velox.tags[index]);
+	wl_list_for_each (screen, &velox.screens, link)
+		screen_flush(screen);
+	snapshot_flush();
+	trace_end("flush");
+
+	stats_record(STATS_UPDATE, start);
 }
 
 struct tag *
-next_tag(uint32_t *tags)
+next_tag(struct tag_mask *tags)
 {
-	unsigned index = __builtin_ffsl(*tags);
-	struct tag *tag;
+	unsigned word, bit;
 
-	if (index == 0)
-		return NULL;
+	for (word = 0; word < TAG_MASK_WORDS; ++word) {
+		if (!tags->words[word])
+			continue;
 
-	tag = velox.tags[index - 1];
-	*tags &= ~tag->mask;
+		bit = __builtin_ctzll(tags->words[word]);
+		tags->words[word] &= tags->words[word] - 1;
 
-	return tag;
+		return velox.tags[word * 64 + bit];
+	}
+
+	return NULL;
 }
 
 struct tag *
@@ -224,6 +327,54 @@ focus_prev(struct config_node *node, const struct variant *v)
 	screen_focus_prev(velox.active_screen);
 }
 
+static void
+focus_left(struct config_node *node, const struct variant *v)
+{
+	screen_focus_direction(velox.active_screen, DIRECTION_LEFT);
+}
+
+static void
+focus_right(struct config_node *node, const struct variant *v)
+{
+	screen_focus_direction(velox.active_screen, DIRECTION_RIGHT);
+}
+
+static void
+focus_up(struct config_node *node, const struct variant *v)
+{
+	screen_focus_direction(velox.active_screen, DIRECTION_UP);
+}
+
+static void
+focus_down(struct config_node *node, const struct variant *v)
+{
+	screen_focus_direction(velox.active_screen, DIRECTION_DOWN);
+}
+
+static void
+screen_left(struct config_node *node, const struct variant *v)
+{
+	screen_activate_direction(velox.active_screen, DIRECTION_LEFT);
+}
+
+static void
+screen_right(struct config_node *node, const struct variant *v)
+{
+	screen_activate_direction(velox.active_screen, DIRECTION_RIGHT);
+}
+
+static void
+screen_up(struct config_node *node, const struct variant *v)
+{
+	screen_activate_direction(velox.active_screen, DIRECTION_UP);
+}
+
+static void
+screen_down(struct config_node *node, const struct variant *v)
+{
+	screen_activate_direction(velox.active_screen, DIRECTION_DOWN);
+}
+
 static void
 zoom(struct config_node *node, const struct variant *v)
 {
@@ -246,7 +397,7 @@ zoom(struct config_node *node, const struct variant *v)
 
 	wl_list_remove(link);
 	wl_list_insert(&screen->windows, link);
-	arrange();
+	schedule_update(screen);
 }
 
 static void
@@ -259,17 +410,30 @@ layout_next(struct config_node *node, const struct variant *v)
 	if ((link = (*layout)->link.next) == &screen->layouts)
 		link = link->next;
 	*layout = wl_container_of(link, *layout, link);
-	screen_arrange(screen);
+	schedule_update(screen);
 }
 
 static void
 previous_tags(struct config_node *node, const struct variant *v)
 {
-	uint32_t mask = velox.active_screen->last_mask;
+	struct tag_mask mask = velox.active_screen->last_mask;
 
 	velox.active_screen->last_mask = velox.active_screen->mask;
-	screen_set_tags(velox.active_screen, mask);
-	update();
+	screen_set_tags(velox.active_screen, &mask);
+}
+
+static void
+handle_reload(void *data)
+{
+	config_reload();
+}
+
+static void
+reload(struct config_node *node, const struct variant *v)
+{
+	/* The action may have been invoked by a binding or rule from the current
+	 * config, so wait until it has returned before replacing it. */
+	wl_event_loop_add_idle(velox.event_loop, &handle_reload, NULL);
 }
 
 static void
@@ -280,24 +444,52 @@ quit(struct config_node *node, const struct variant *v)
 
 static CONFIG_ACTION(focus_next, &focus_next);
 static CONFIG_ACTION(focus_prev, &focus_prev);
+static CONFIG_ACTION(focus_left, &focus_left);
+static CONFIG_ACTION(focus_right, &focus_right);
+static CONFIG_ACTION(focus_up, &focus_up);
+static CONFIG_ACTION(focus_down, &focus_down);
+static CONFIG_ACTION(screen_left, &screen_left);
+static CONFIG_ACTION(screen_right, &screen_right);
+static CONFIG_ACTION(screen_up, &screen_up);
+static CONFIG_ACTION(screen_down, &screen_down);
 static CONFIG_ACTION(zoom, &zoom);
 static CONFIG_ACTION(layout_next, &layout_next);
 static CONFIG_ACTION(previous_tags, &previous_tags);
+static CONFIG_ACTION(reload, &reload);
 static CONFIG_ACTION(quit, &quit);
 
-static void
+static bool
 add_config_nodes()
 {
-	wl_list_insert(config_root, &focus_next_action.link);
-	wl_list_insert(config_root, &focus_prev_action.link);
-	wl_list_insert(config_root, &zoom_action.link);
-	wl_list_insert(config_root, &layout_next_action.link);
-	wl_list_insert(config_root, &previous_tags_action.link);
-	wl_list_insert(config_root, &quit_action.link);
+	static struct config_node *const nodes[] = {
+		&focus_next_action,
+		&focus_prev_action,
+		&focus_left_action,
+		&focus_right_action,
+		&focus_up_action,
+		&focus_down_action,
+		&screen_left_action,
+		&screen_right_action,
+		&screen_up_action,
+		&screen_down_action,
+		&zoom_action,
+		&layout_next_action,
+		&previous_tags_action,
+		&reload_action,
+		&quit_action,
+	};
+	unsigned index;
+
+	for (index = 0; index < ARRAY_LENGTH(nodes); ++index) {
+		if (!config_add_node(config_root, nodes[index]))
+			return false;
+	}
 
-	layout_add_config_nodes();
-	tag_add_config_nodes();
-	window_add_config_nodes();
+	return animation_add_config_nodes()
+	    && layout_add_config_nodes()
+	    && screen_add_config_nodes()
+	    && tag_add_config_nodes()
+	    && window_add_config_nodes();
 }
 
 static void
@@ -311,10 +503,7 @@ start_clients()
 	char status_bar_path[strlen(dir) + 1 + strlen(status_bar) + 1];
 	sprintf(status_bar_path, "%s/%s", dir, status_bar);
 
-	if (fork() == 0) {
-		execl(status_bar_path, status_bar, NULL);
-		exit(EXIT_FAILURE);
-	}
+	process_spawn((char *[]){ status_bar_path, NULL }, false);
 }
 
 static int
@@ -326,14 +515,21 @@ handle_chld(int num, void *data)
 	return 0;
 }
 
+static int
+handle_hup(int num, void *data)
+{
+	config_reload();
+	return 0;
+}
+
 static void
 bind_velox(struct wl_client *client, void *data,
            uint32_t version, uint32_t id)
 {
 	struct wl_resource *resource;
 
-	if (version >= 1)
-		version = 1;
+	if (version >= 5)
+		version = 5;
 
 	if (!(resource = wl_resource_create(client, &velox_interface, version, id))) {
 		wl_client_post_no_memory(client);
@@ -346,8 +542,28 @@ bind_velox(struct wl_client *client, void *data,
 int
 main(int argc, char *argv[])
 {
-	int index;
-	char tag_name[] = "1";
+	int index, option;
+	unsigned long num_tags;
+	char tag_name[8], *end;
+	struct timespec start;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while ((option = getopt(argc, argv, "t:")) != -1) {
+		switch (option) {
+		case 't':
+			num_tags = strtoul(optarg, &end, 10);
+			if (*end || num_tags == 0 || num_tags > MAX_TAGS) {
+				fprintf(stderr, "The number of tags must be between 1 and %u\n", MAX_TAGS);
+				goto error0;
+			}
+			velox.num_tags = num_tags;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-t num_tags]\n", argv[0]);
+			goto error0;
+		}
+	}
 
 	velox.display = wl_display_create();
 
@@ -357,7 +573,7 @@ main(int argc, char *argv[])
 	if (wl_display_add_socket(velox.display, NULL) != 0)
 		goto error1;
 
-	velox.global = wl_global_create(velox.display, &velox_interface, 1, NULL, &bind_velox);
+	velox.global = wl_global_create(velox.display, &velox_interface, 5, NULL, &bind_velox);
 
 	if (!velox.global)
 		goto error1;
@@ -365,39 +581,54 @@ main(int argc, char *argv[])
 	velox.event_loop = wl_display_get_event_loop(velox.display);
 	wl_event_loop_add_signal(velox.event_loop, SIGCHLD, &handle_chld, NULL);
 	wl_list_init(&velox.screens);
-	wl_list_init(&velox.hidden_windows);
+	wl_list_init(&velox.visibility_changes);
 	wl_list_init(&velox.unused_tags);
-	wl_list_init(&velox.rules);
-	add_config_nodes();
+	wl_event_loop_add_signal(velox.event_loop, SIGHUP, &handle_hup, NULL);
+	if (!add_config_nodes())
+		goto error2;
 
-	for (index = 0; index < NUM_TAGS; ++index, ++tag_name[0]) {
+	for (index = 0; index < velox.num_tags; ++index) {
+		snprintf(tag_name, sizeof tag_name, "%d", index + 1);
 		if (!(velox.tags[index] = tag_new(index, tag_name)))
-			goto error2;
+			goto error3;
 	}
 
 	/* Mark tags as unused in reverse order, so that they are claimed in ascending
 	 * order. */
-	for (index = NUM_TAGS - 1; index >= 0; --index)
+	for (index = velox.num_tags - 1; index >= 0; --index)
 		tag_add(velox.tags[index], NULL);
 
+	/* Neither swc nor the config parser depend on each other, so parse the
+	 * config while swc initializes. */
+	if (!config_parse_start())
+		goto error3;
+
 	if (!swc_initialize(velox.display, NULL, &manager))
-		goto error2;
+		goto error4;
 
-	if (!config_parse())
-		goto error3;
+	if (!config_parse_finish())
+		goto error5;
 
 	start_clients();
+	trace_initialize();
+	fprintf(stderr, "Started in %.3f ms\n", elapsed_ms(&start));
 
 	wl_display_run(velox.display);
+	trace_finalize();
 	swc_finalize();
 
+	stats_print(stderr);
+
 	return EXIT_SUCCESS;
 
-error3:
+error5:
 	swc_finalize();
-error2:
+error4:
+	config_parse_cancel();
+error3:
 	while (index > 0)
 		tag_destroy(velox.tags[--index]);
+error2:
 	wl_global_destroy(velox.global);
 error1:
 	wl_display_destroy(velox.display);
@@ -25,45 +25,72 @@
 #ifndef VELOX_VELOX_H
 #define VELOX_VELOX_H
 
-#include <wayland-util.h>
+#include "rule.h"
 
-#define NUM_TAGS 9
+#include <wayland-util.h>
 
-struct window;
+/* The most tags velox can be started with, and the number it uses unless
+ * told otherwise. */
+#define MAX_TAGS 64
+#define DEFAULT_NUM_TAGS 9
 
-struct rule {
-	enum {
-		RULE_TYPE_WINDOW_TITLE,
-		RULE_TYPE_APP_ID,
-	} type;
-	char *identifier;
-	struct config_node *action;
+#define TAG_MASK_WORDS ((MAX_TAGS + 63) / 64)
 
-	struct wl_list link;
+/* A set of tags, by their index in velox.tags. */
+struct tag_mask {
+	uint64_t words[TAG_MASK_WORDS];
 };
 
+struct screen;
+struct window;
+
 struct velox {
 	struct wl_display *display;
 	struct wl_event_loop *event_loop;
 	struct screen *active_screen;
 	struct wl_list screens;
-	struct wl_list hidden_windows;
+	struct wl_list visibility_changes;
 	struct wl_list unused_tags;
-	struct wl_list rules;
-	struct tag *tags[NUM_TAGS];
+	struct rules *rules;
+	unsigned num_tags;
+	struct tag *tags[MAX_TAGS];
 
 	struct wl_global *global;
+	struct wl_event_source *update_source;
 };
 
 extern struct velox velox;
+/* The border width given to new screens. */
 extern unsigned border_width;
 
 void manage(struct window *window);
 void unmanage(struct window *window);
+
+/**
+ * Mark a screen as needing to be arranged, and schedule an update to run once
+ * the event loop becomes idle.
+ *
+ * screen may be NULL, in which case only pending visibility changes are
+ * applied and queued protocol events are sent.
+ */
+void schedule_update(struct screen *screen);
+
+/**
+ * Schedule all screens to be arranged.
+ */
 void arrange();
+
+/**
+ * Arrange the dirty screens, apply pending visibility changes and send queued
+ * protocol events immediately.
+ */
 void update();
 
-struct tag *next_tag(uint32_t *tags);
+/**
+ * Remove the tag with the lowest index from a set of tags and return it, or
+ * return NULL if the set is empty.
+ */
+struct tag *next_tag(struct tag_mask *tags);
 struct tag *find_unused_tag();
 
 #endif
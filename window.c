@@ -24,19 +24,37 @@
 #include "window.h"
 #include "config.h"
 #include "screen.h"
+#include "stats.h"
 #include "tag.h"
+#include "trace.h"
+#include "util.h"
 #include "velox.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <swc.h>
 
+static struct pool windows = POOL_INITIALIZER(struct window);
+
 static uint32_t border_color_active = 0xff338833;
 static uint32_t border_color_inactive = 0xff888888;
 
 static bool
 border_width_set(struct config_node *node, const char *value)
 {
-	return config_set_unsigned(&border_width, value, 0);
+	struct screen *screen;
+
+	if (!config_set_unsigned(&border_width, value, 0))
+		return false;
+
+	wl_list_for_each (screen, &velox.screens, link) {
+		if (screen->border_width == border_width)
+			continue;
+		screen->border_width = border_width;
+		schedule_update(screen);
+	}
+
+	return true;
 }
 
 static bool
@@ -51,6 +69,24 @@ border_color_inactive_set(struct config_node *node, const char *value)
 	return config_set_unsigned(&border_color_inactive, value, 16);
 }
 
+static void
+border_width_get(struct config_node *node, char *value, size_t size)
+{
+	config_get_unsigned(value, size, border_width, 10);
+}
+
+static void
+border_color_active_get(struct config_node *node, char *value, size_t size)
+{
+	config_get_unsigned(value, size, border_color_active, 16);
+}
+
+static void
+border_color_inactive_get(struct config_node *node, char *value, size_t size)
+{
+	config_get_unsigned(value, size, border_color_inactive, 16);
+}
+
 static void
 begin_move(struct config_node *node, const struct variant *v)
 {
@@ -60,6 +96,8 @@ begin_move(struct config_node *node, const struct variant *v)
 		return;
 
 	window_set_layer(w, STACK);
+	if (w->tag->screen)
+		screen_raise(w->tag->screen, w);
 	swc_window_begin_move(w->swc);
 }
 
@@ -83,6 +121,8 @@ begin_resize(struct config_node *node, const struct variant *v)
 		return;
 
 	window_set_layer(w, STACK);
+	if (w->tag->screen)
+		screen_raise(w->tag->screen, w);
 	swc_window_begin_resize(w->swc, SWC_WINDOW_EDGE_AUTO);
 }
 
@@ -108,6 +148,28 @@ switch_layer(struct config_node *node, const struct variant *v)
 	window_set_layer(w, (w->layer + 1) % NUM_LAYERS);
 }
 
+static void
+raise_window(struct config_node *node, const struct variant *v)
+{
+	struct window *w = window_or_focus(v);
+
+	if (!w || !w->tag->screen)
+		return;
+
+	screen_raise(w->tag->screen, w);
+}
+
+static void
+lower_window(struct config_node *node, const struct variant *v)
+{
+	struct window *w = window_or_focus(v);
+
+	if (!w || !w->tag->screen)
+		return;
+
+	screen_lower(w->tag->screen, w);
+}
+
 static void
 close_window(struct config_node *node, const struct variant *v)
 {
@@ -120,29 +182,33 @@ close_window(struct config_node *node, const struct variant *v)
 }
 
 static CONFIG_GROUP(window);
-static CONFIG_PROPERTY(border_width, &border_width_set);
-static CONFIG_PROPERTY(border_color_active, &border_color_active_set);
-static CONFIG_PROPERTY(border_color_inactive, &border_color_inactive_set);
+static CONFIG_PROPERTY(border_width, &border_width_set, &border_width_get);
+static CONFIG_PROPERTY(border_color_active, &border_color_active_set, &border_color_active_get);
+static CONFIG_PROPERTY(border_color_inactive, &border_color_inactive_set, &border_color_inactive_get);
 static CONFIG_ACTION(begin_move, &begin_move);
 static CONFIG_ACTION(end_move, &end_move);
 static CONFIG_ACTION(begin_resize, &begin_resize);
 static CONFIG_ACTION(end_resize, &end_resize);
 static CONFIG_ACTION(switch_layer, &switch_layer);
+static CONFIG_ACTION(raise, &raise_window);
+static CONFIG_ACTION(lower, &lower_window);
 static CONFIG_ACTION(close, &close_window);
 
-void
+bool
 window_add_config_nodes()
 {
-	wl_list_insert(&window_group.group, &border_width_property.link);
-	wl_list_insert(&window_group.group, &border_color_active_property.link);
-	wl_list_insert(&window_group.group, &border_color_inactive_property.link);
-	wl_list_insert(&window_group.group, &begin_move_action.link);
-	wl_list_insert(&window_group.group, &end_move_action.link);
-	wl_list_insert(&window_group.group, &begin_resize_action.link);
-	wl_list_insert(&window_group.group, &end_resize_action.link);
-	wl_list_insert(&window_group.group, &switch_layer_action.link);
-	wl_list_insert(&window_group.group, &close_action.link);
-	wl_list_insert(config_root, &window_group.link);
+	return config_add_node(&window_group, &border_width_property)
+	    && config_add_node(&window_group, &border_color_active_property)
+	    && config_add_node(&window_group, &border_color_inactive_property)
+	    && config_add_node(&window_group, &begin_move_action)
+	    && config_add_node(&window_group, &end_move_action)
+	    && config_add_node(&window_group, &begin_resize_action)
+	    && config_add_node(&window_group, &end_resize_action)
+	    && config_add_node(&window_group, &switch_layer_action)
+	    && config_add_node(&window_group, &raise_action)
+	    && config_add_node(&window_group, &lower_action)
+	    && config_add_node(&window_group, &close_action)
+	    && config_add_node(config_root, &window_group);
 }
 
 static void
@@ -150,8 +216,23 @@ destroy(void *data)
 {
 	struct window *window = data;
 
+	animation_cancel(window);
 	unmanage(window);
-	free(window);
+	free(window->rules_title);
+	pool_free(&windows, window);
+}
+
+static void
+apply_title_rules(struct window *window)
+{
+	const char *title = window->swc->title;
+
+	if (!title || (window->rules_title && strcmp(title, window->rules_title) == 0))
+		return;
+
+	free(window->rules_title);
+	window->rules_title = strdup(title);
+	rules_apply(velox.rules, RULE_TYPE_WINDOW_TITLE, window);
 }
 
 static void
@@ -159,21 +240,60 @@ title_changed(void *data)
 {
 	struct window *window = data;
 
+	trace_begin("title_changed");
+	apply_title_rules(window);
+
 	/* If this window focused on a screen, make sure bound clients are aware of
 	 * this title change. */
 	if (window->tag->screen && window->tag->screen->focus == window)
-		screen_focus_notify(window->tag->screen);
+		screen_title_notify(window->tag->screen);
+	trace_end("title_changed");
+}
+
+/* Find the window managing an swc window, if it has a tag. */
+static struct window *
+find_window(struct swc_window *swc)
+{
+	struct window *window;
+	unsigned index;
+
+	for (index = 0; index < velox.num_tags; ++index) {
+		wl_list_for_each (window, &velox.tags[index]->windows, tag_link) {
+			if (window->swc == swc)
+				return window;
+		}
+	}
+
+	return NULL;
 }
 
 static void
 parent_changed(void *data)
 {
-	struct window *window = data;
+	struct window *window = data, *parent;
+	const struct swc_rectangle *area;
+
+	if (!window->swc->parent)
+		return;
 
-	if (window->swc->parent)
-		window_set_layer(window, STACK);
+	window_set_layer(window, STACK);
 
-	/* TODO: We should probably center this window in the parent. */
+	/* Center the window on its parent at half its size, or on the screen if
+	 * the parent's geometry isn't known. */
+	parent = find_window(window->swc->parent);
+	if (parent && window_target_geometry(parent)->width != 0)
+		area = window_target_geometry(parent);
+	else if (window->tag && window->tag->screen)
+		area = &window->tag->screen->swc->usable_geometry;
+	else
+		return;
+
+	window_configure(window, &(struct swc_rectangle){
+		.x = area->x + area->width / 4,
+		.y = area->y + area->height / 4,
+		.width = area->width / 2,
+		.height = area->height / 2,
+	});
 }
 
 static void
@@ -181,8 +301,10 @@ entered(void *data)
 {
 	struct window *window = data;
 
+	trace_begin("window_entered");
 	window_focus(window);
 	window->tag->screen->focus = window;
+	trace_end("window_entered");
 }
 
 static void
@@ -215,12 +337,21 @@ window_new(struct swc_window *swc)
 {
 	struct window *window;
 
-	if (!(window = malloc(sizeof *window)))
+	if (!(window = pool_alloc(&windows)))
 		return NULL;
 
 	window->swc = swc;
+	wl_list_init(&window->link);
 	window->tag = NULL;
+	wl_list_init(&window->stack_link);
 	window->layer = STACK;
+	window->rules_title = NULL;
+	window->visible = false;
+	window->occluded = false;
+	window->shown = false;
+	wl_list_init(&window->visibility_link);
+	memset(&window->geometry, 0, sizeof window->geometry);
+	wl_list_init(&window->animation.link);
 
 	window_set_layer(window, TILE);
 	swc_window_set_handler(swc, &window_handler, window);
@@ -228,37 +359,133 @@ window_new(struct swc_window *swc)
 	return window;
 }
 
+static unsigned
+window_border_width(struct window *window)
+{
+	return window->tag && window->tag->screen ? window->tag->screen->border_width : border_width;
+}
+
 void
 window_focus(struct window *window)
 {
-	/* This will become stale if the focused window is destroyed. However, we make
-	 * sure to change the focus of a screen in screen_remove_windows when its
-	 * focus is removed (before it is actually destroyed). */
-	static struct window *focused_window;
+	static struct handle focused;
+	struct window *focused_window;
 
-	if (focused_window)
-		swc_window_set_border(focused_window->swc, border_color_inactive, border_width);
+	/* The previously focused window may have been destroyed since. */
+	if ((focused_window = window_from_handle(focused)))
+		swc_window_set_border(focused_window->swc, border_color_inactive, window_border_width(focused_window));
 
 	if (window) {
-		swc_window_set_border(window->swc, border_color_active, border_width);
+		swc_window_set_border(window->swc, border_color_active, window_border_width(window));
 		swc_window_focus(window->swc);
 	} else {
 		swc_window_focus(NULL);
 	}
 
-	focused_window = window;
+	focused = window ? window_handle(window) : (struct handle){ 0 };
+}
+
+struct handle
+window_handle(struct window *window)
+{
+	return pool_handle(&windows, window);
+}
+
+struct window *
+window_from_handle(struct handle handle)
+{
+	return pool_get(&windows, handle);
+}
+
+void
+window_apply_rules(struct window *window)
+{
+	rules_apply(velox.rules, RULE_TYPE_APP_ID, window);
+	apply_title_rules(window);
 }
 
 void
 window_show(struct window *window)
 {
 	swc_window_show(window->swc);
+	stats_count(STATS_SHOWS);
+	window->shown = true;
 }
 
 void
 window_hide(struct window *window)
 {
+	animation_finish(window);
 	swc_window_hide(window->swc);
+	stats_count(STATS_HIDES);
+	window->shown = false;
+}
+
+static void
+queue_visibility_change(struct window *window)
+{
+	/* Queue the window so the next update applies the change. */
+	if (wl_list_empty(&window->visibility_link))
+		wl_list_insert(velox.visibility_changes.prev, &window->visibility_link);
+}
+
+void
+window_set_visible(struct window *window, bool visible)
+{
+	window->visible = visible;
+	queue_visibility_change(window);
+}
+
+void
+window_set_occluded(struct window *window, bool occluded)
+{
+	if (occluded == window->occluded)
+		return;
+
+	window->occluded = occluded;
+	queue_visibility_change(window);
+}
+
+bool
+window_should_show(struct window *window)
+{
+	return window->visible && !window->occluded;
+}
+
+void
+window_set_geometry(struct window *window, const struct swc_rectangle *geometry)
+{
+	const struct swc_rectangle *current = window_target_geometry(window);
+
+	if (current->x == geometry->x && current->y == geometry->y
+	    && current->width == geometry->width && current->height == geometry->height) {
+		stats_count(STATS_CONFIGURES_SKIPPED);
+		return;
+	}
+
+	/* Hidden windows, and ones that were never configured, have nothing to
+	 * animate from. */
+	if (animation_enabled() && window->shown && window->geometry.width != 0) {
+		animation_start(window, geometry);
+		return;
+	}
+
+	animation_cancel(window);
+	window_configure(window, geometry);
+}
+
+const struct swc_rectangle *
+window_target_geometry(struct window *window)
+{
+	return animation_running(&window->animation) ? &window->animation.to : &window->geometry;
+}
+
+void
+window_configure(struct window *window, const struct swc_rectangle *geometry)
+{
+	swc_window_set_geometry(window->swc, geometry);
+	window->geometry = *geometry;
+	stats_count(STATS_CONFIGURES);
 }
 
 void
@@ -271,10 +498,14 @@ window_set_tag(struct window *window, struct tag *tag)
 
 	window->tag = tag;
 
-	if (old_tag)
+	if (old_tag) {
+		wl_list_remove(&window->tag_link);
 		tag_update_num_windows(old_tag, -1);
-	if (tag)
+	}
+	if (tag) {
+		wl_list_insert(tag->windows.prev, &window->tag_link);
 		tag_update_num_windows(tag, +1);
+	}
 
 	/* If the focused window changes tag, but not screen, make sure the
 	 * screen notifies any clients of the new tag. */
@@ -285,14 +516,15 @@ window_set_tag(struct window *window, struct tag *tag)
 	}
 
 	if (old_tag && old_tag->screen)
-		screen_remove_windows(old_tag->screen);
+		screen_remove_window(old_tag->screen, window);
 	if (tag && tag->screen)
-		screen_add_windows(tag->screen);
+		screen_add_window(tag->screen, window);
 }
 
 void
 window_set_layer(struct window *window, int layer)
 {
+	struct screen *screen;
 	int old_layer = window->layer;
 
 	if (layer == old_layer)
@@ -310,10 +542,24 @@ window_set_layer(struct window *window, int layer)
 		break;
 	}
 
+	/* The window's geometry is now up to the client or the user, so make sure
+	 * it gets configured again if it is tiled later. */
+	animation_cancel(window);
+	memset(&window->geometry, 0, sizeof window->geometry);
+
 	if (window->tag && window->tag->screen) {
-		--window->tag->screen->num_windows[old_layer];
-		++window->tag->screen->num_windows[layer];
-		update();
+		screen = window->tag->screen;
+		--screen->num_windows[old_layer];
+		++screen->num_windows[layer];
+
+		/* Stacked windows start on top, and tiled ones go below all of
+		 * them. */
+		wl_list_remove(&window->stack_link);
+		wl_list_init(&window->stack_link);
+		if (layer == STACK)
+			wl_list_insert(screen->stack.prev, &window->stack_link);
+		screen->restack = true;
+		schedule_update(screen);
 	}
 }
 
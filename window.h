@@ -24,6 +24,11 @@
 #ifndef VELOX_WINDOW_H
 #define VELOX_WINDOW_H
 
+#include "animation.h"
+#include "util.h"
+
+#include <stdbool.h>
+#include <swc.h>
 #include <wayland-server.h>
 
 struct swc_window;
@@ -31,18 +36,83 @@ struct variant;
 
 struct window {
 	struct swc_window *swc;
+	/* Link in the screen's window list, if the window is visible. */
 	struct wl_list link;
 
 	int layer;
 	struct tag *tag;
+	struct wl_list tag_link;
+	/* Link in the screen's stacking list, if the window is visible and
+	 * stacked. */
+	struct wl_list stack_link;
+
+	/* The title that rules were last applied for. */
+	char *rules_title;
+
+	/* The last geometry sent to swc, or all zeros if unknown. */
+	struct swc_rectangle geometry;
+	struct animation animation;
+
+	/* Whether the window is in a screen's window list, whether the layout of
+	 * that screen covers it with another window, and whether it was last shown
+	 * by swc. When the window should be shown but isn't, or the other way
+	 * around, it is in velox.visibility_changes. */
+	bool visible, occluded, shown;
+	struct wl_list visibility_link;
 };
 
-void window_add_config_nodes();
+bool window_add_config_nodes();
 
 struct window *window_new(struct swc_window *swc);
 void window_focus(struct window *window);
+
+/**
+ * Get a handle to a window, which can be kept after the window is destroyed
+ * without becoming a dangling pointer.
+ */
+struct handle window_handle(struct window *window);
+
+/**
+ * Get the window a handle refers to, or NULL if it no longer exists.
+ */
+struct window *window_from_handle(struct handle handle);
+
+/**
+ * Apply the app_id and title rules matching the window. Title rules are only
+ * applied if the title has changed since they were last applied.
+ */
+void window_apply_rules(struct window *window);
+
 void window_show(struct window *window);
 void window_hide(struct window *window);
+void window_set_visible(struct window *window, bool visible);
+void window_set_occluded(struct window *window, bool occluded);
+
+/**
+ * Whether the window should be shown by swc once pending visibility changes
+ * are applied.
+ */
+bool window_should_show(struct window *window);
+
+/**
+ * Configure the window with the given geometry, unless it is the same as the
+ * last geometry it was configured with, or the one it is animating towards.
+ *
+ * Shown windows are animated to their new geometry if animations are
+ * enabled.
+ */
+void window_set_geometry(struct window *window, const struct swc_rectangle *geometry);
+
+/**
+ * Get the geometry the window is animating towards, or the one it was last
+ * sent if it isn't animating.
+ */
+const struct swc_rectangle *window_target_geometry(struct window *window);
+
+/**
+ * Send a geometry to swc immediately.
+ */
+void window_configure(struct window *window, const struct swc_rectangle *geometry);
 
 void window_set_tag(struct window *window, struct tag *tag);
 void window_set_layer(struct window *window, int layer);